@@ -0,0 +1,24 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <stddef.h>
+
+// allocations are aligned for the widest vector loads
+#define ARENA_ALIGN 64
+
+typedef struct ArenaBlock ArenaBlock;
+
+// bump allocator, everything in it is freed at once by arena_reset
+typedef struct {
+    ArenaBlock *block;          /* block allocations come from, or NULL */
+    size_t      block_size;     /* smallest block to ask the system for */
+    void       *last;           /* latest allocation, arena_grow extends it in place */
+} Arena;
+
+void  arena_init(Arena *a, size_t block_size);
+void *arena_alloc(Arena *a, size_t size);
+void *arena_grow(Arena *a, void *p, size_t old_size, size_t size);
+void  arena_reset(Arena *a);
+void  arena_free(Arena *a);
+
+#endif // ARENA_H
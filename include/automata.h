@@ -1,14 +1,24 @@
 #ifndef AUTOMATA_H
 #define AUTOMATA_H
 
-// SDL Rendering for Simulation
+// SDL Rendering for Simulation, initial size of the resizable window
 #define SCREEN_WIDTH    810
 #define SCREEN_HEIGHT   610
 
+// boundary conditions for the edges of a row
+typedef enum {
+    BOUNDARY_PERIODIC,      /* row wraps around */
+    BOUNDARY_FIXED0,        /* cells past the edges are always 0 */
+    BOUNDARY_FIXED1,        /* cells past the edges are always 1 */
+    BOUNDARY_REFLECT,       /* edge cells are mirrored past the edges */
+    BOUNDARY_GROW,          /* unbounded row, only the light cone is stored */
+    BOUNDARY_COUNT
+} Boundary;
+
 // simulation functions
 int calculateState(int left, int curr, int right);
 void getNextGeneration(void);
-void drawGeneration(int y);
+void drawGeneration(unsigned char *states);
 void renderAutomata(void);
 
 #endif // AUTOMATA_H
@@ -0,0 +1,36 @@
+#ifndef BASINS_H
+#define BASINS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// largest ring whose state transition graph basins_compute maps
+#define BASINS_MAX_CELLS 30
+
+// one attractor cycle of a ring
+typedef struct {
+    uint32_t    state;          /* smallest state on the cycle */
+    uint32_t    period;
+    uint32_t    basin;          /* states flowing into the cycle, itself included */
+} BasinCycle;
+
+// complete state transition graph of a ring under a rule
+typedef struct {
+    int         rule;
+    int         cells;          /* ring size */
+    uint64_t    states;         /* 2^cells */
+    uint32_t   *succ;           /* successor of each state */
+    uint32_t   *basin;          /* index in cycle of the attractor of each state */
+    BasinCycle *cycle;          /* attractors by smallest state */
+    uint32_t    cycles;
+    uint64_t    cycle_states;   /* states lying on a cycle */
+    uint32_t    max_indegree;
+    uint64_t    indegree[BASINS_MAX_CELLS + 2];  /* [0] states without a predecessor,
+                                                    [k] in-degree in [2^(k-1), 2^k) */
+} Basins;
+
+ int  basins_compute(Basins *b, int rule, int cells, int threads);
+void  basins_write(FILE *f, const Basins *b);
+void  basins_free(Basins *b);
+
+#endif // BASINS_H
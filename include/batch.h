@@ -0,0 +1,30 @@
+#ifndef BATCH_H
+#define BATCH_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "automata.h"
+#include "seed.h"
+
+#define BATCH_ROWS 64
+
+// 64 rows of one rule and width stepped together, bit j of cells[x + 1] is cell x of row j
+typedef struct {
+    int         rule;
+    Boundary    boundary;
+    size_t      width;
+    uint64_t   *cells;          /* width + 2 words, the outer two hold the boundary */
+    uint64_t   *next;           /* scratch buffer for batch_step */
+    uint64_t    generation;
+} Batch;
+
+int  batch_init(Batch *b, int rule, size_t width, Boundary boundary);
+void batch_free(Batch *b);
+int  batch_seed(Batch *b, int row, const SeedSpec *spec);
+int  batch_seed_all(Batch *b, const SeedSpec *spec);
+void batch_step(Batch *b);
+void batch_extract(const Batch *b, int row, uint64_t *words);
+int  batch_get(const Batch *b, int row, size_t x);
+
+#endif // BATCH_H
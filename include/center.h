@@ -0,0 +1,12 @@
+#ifndef CENTER_H
+#define CENTER_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+#include "seed.h"
+
+// centre column of a growing row as a stream of random looking bits
+uint64_t center_column(int rule, const SeedSpec *spec, size_t width, uint64_t bits, FILE *out);
+
+#endif // CENTER_H
@@ -0,0 +1,7 @@
+#ifndef CLI_H
+#define CLI_H
+
+// headless entry point, used when the program is started with arguments
+int cli_main(int argc, char **argv);
+
+#endif // CLI_H
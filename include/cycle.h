@@ -0,0 +1,24 @@
+#ifndef CYCLE_H
+#define CYCLE_H
+
+#include <stdint.h>
+
+#include "engine.h"
+#include "seed.h"
+
+// Brent's cycle detection over the generations of an engine
+typedef struct {
+    uint64_t    power;          /* distance at which the mark moves on */
+    uint64_t    mark_gen;       /* generation of the marked row */
+    uint64_t    mark_hash;
+    uint64_t   *mark_row;       /* copy of the marked row, rules out collisions */
+    size_t      mark_words;
+    uint64_t    period;         /* 0 until a cycle is found */
+} Cycle;
+
+     int  cycle_init(Cycle *c, Engine *e);
+     void cycle_free(Cycle *c);
+     int  cycle_update(Cycle *c, const Engine *e);
+uint64_t  cycle_transient(const Engine *e, const SeedSpec *spec, uint64_t period);
+
+#endif // CYCLE_H
@@ -0,0 +1,71 @@
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "automata.h"
+#include "pool.h"
+#include "seed.h"
+#include "stats.h"
+
+// placement of a large row, see engine_init_ex
+typedef struct {
+    int         threads;        /* workers stepping stripes of the row, 0 for one per CPU */
+    int         huge_pages;     /* back the row with huge pages where the system has them */
+    int         pin;            /* pin each worker to its own CPU */
+} EngineOptions;
+
+// random deviations from the rule, see engine_set_noise
+typedef struct {
+    double      p;              /* probability of a cell deviating, 0 for none */
+    int         rule;           /* rule the deviating cells follow, -1 to flip them */
+    uint64_t    seed;
+} Noise;
+
+// bit packed row stepper, bit p of a buffer is words[p / 64] >> (p % 64)
+typedef struct {
+    int         rule;
+    Boundary    boundary;
+    uint64_t   *row;            /* current generation */
+    uint64_t   *next;           /* scratch buffer for engine_step */
+    uint64_t   *prev;           /* generation before row for second-order rows, else NULL */
+    uint64_t   *map;            /* rule of each cell as 8 bit planes per word, or NULL */
+    Noise       noise;
+    size_t      words;          /* capacity of both buffers */
+    size_t      width;          /* cells written by engine_seed */
+    long long   lo, hi;         /* stored cells are the bits [lo, hi) */
+    long long   origin;         /* bit position of cell 0 */
+    int         background;     /* state of the cells outside [lo, hi) */
+    uint64_t    generation;
+    int         hashing;        /* keep hash up to date */
+    uint64_t    hash;           /* hash of the stored cells */
+    Stats      *stats;          /* collector for each generation, or NULL */
+    Pool       *pool;           /* workers stepping stripes of the row, or NULL */
+    Stats      *parts;          /* collector of each worker's stripe, or NULL */
+    int         huge;           /* buffers are mapped with huge pages */
+} Engine;
+
+const char *boundary_name(Boundary boundary);
+       int  boundary_parse(const char *name);
+
+       int  engine_init(Engine *e, int rule, size_t width, Boundary boundary);
+       int  engine_init_ex(Engine *e, int rule, size_t width, Boundary boundary,
+                           const EngineOptions *opt);
+       void engine_free(Engine *e);
+       int  engine_seed(Engine *e, const SeedSpec *spec);
+       int  engine_set_previous(Engine *e, const SeedSpec *spec);
+       int  engine_set_rule_map(Engine *e, const unsigned char *rules);
+       int  engine_set_rule_mix(Engine *e, int a, int b, const uint64_t *select);
+       int  engine_copy_rule_map(Engine *e, const Engine *from);
+       int  engine_set_noise(Engine *e, double p, int rule, uint64_t seed);
+       void engine_set_hashing(Engine *e, int on);
+       void engine_set_stats(Engine *e, Stats *stats);
+       void engine_step(Engine *e);
+       void engine_step_back(Engine *e);
+       void engine_jump(Engine *e, uint64_t t);
+       void engine_crop(Engine *e, long long from, long long to);
+       int  engine_equal(const Engine *a, const Engine *b);
+       int  engine_get(const Engine *e, long long x);
+
+#endif // ENGINE_H
@@ -0,0 +1,112 @@
+#ifndef GLFUNCS_H
+#define GLFUNCS_H
+
+#include <SDL2/SDL_opengl.h>
+
+// OpenGL entry points newer than 1.1, which opengl32 on Windows doesn't
+// export, so they are looked up through SDL once a context exists
+#define GL_FUNCS(X) \
+    X(PFNGLGENBUFFERSPROC,              glGenBuffers) \
+    X(PFNGLBINDBUFFERPROC,              glBindBuffer) \
+    X(PFNGLBUFFERDATAPROC,              glBufferData) \
+    X(PFNGLBUFFERSUBDATAPROC,           glBufferSubData)
+
+// shaders and instancing (GL 3.3), only used when the context has them
+#define GL_INSTANCING_FUNCS(X) \
+    X(PFNGLCREATESHADERPROC,            glCreateShader) \
+    X(PFNGLSHADERSOURCEPROC,            glShaderSource) \
+    X(PFNGLCOMPILESHADERPROC,           glCompileShader) \
+    X(PFNGLGETSHADERIVPROC,             glGetShaderiv) \
+    X(PFNGLGETSHADERINFOLOGPROC,        glGetShaderInfoLog) \
+    X(PFNGLDELETESHADERPROC,            glDeleteShader) \
+    X(PFNGLCREATEPROGRAMPROC,           glCreateProgram) \
+    X(PFNGLATTACHSHADERPROC,            glAttachShader) \
+    X(PFNGLBINDATTRIBLOCATIONPROC,      glBindAttribLocation) \
+    X(PFNGLLINKPROGRAMPROC,             glLinkProgram) \
+    X(PFNGLGETPROGRAMIVPROC,            glGetProgramiv) \
+    X(PFNGLGETPROGRAMINFOLOGPROC,       glGetProgramInfoLog) \
+    X(PFNGLDELETEPROGRAMPROC,           glDeleteProgram) \
+    X(PFNGLUSEPROGRAMPROC,              glUseProgram) \
+    X(PFNGLGETUNIFORMLOCATIONPROC,      glGetUniformLocation) \
+    X(PFNGLUNIFORM1IPROC,               glUniform1i) \
+    X(PFNGLUNIFORM1FPROC,               glUniform1f) \
+    X(PFNGLUNIFORM2FPROC,               glUniform2f) \
+    X(PFNGLUNIFORM4FVPROC,              glUniform4fv) \
+    X(PFNGLVERTEXATTRIBPOINTERPROC,     glVertexAttribPointer) \
+    X(PFNGLENABLEVERTEXATTRIBARRAYPROC, glEnableVertexAttribArray) \
+    X(PFNGLDISABLEVERTEXATTRIBARRAYPROC, glDisableVertexAttribArray) \
+    X(PFNGLVERTEXATTRIBDIVISORPROC,     glVertexAttribDivisor) \
+    X(PFNGLDRAWARRAYSINSTANCEDPROC,     glDrawArraysInstanced)
+
+// framebuffer objects, pixel buffer read back and fences (GL 3.2), used
+// for offscreen rendering and frame capture
+#define GL_CAPTURE_FUNCS(X) \
+    X(PFNGLGENFRAMEBUFFERSPROC,         glGenFramebuffers) \
+    X(PFNGLBINDFRAMEBUFFERPROC,         glBindFramebuffer) \
+    X(PFNGLCHECKFRAMEBUFFERSTATUSPROC,  glCheckFramebufferStatus) \
+    X(PFNGLGENRENDERBUFFERSPROC,        glGenRenderbuffers) \
+    X(PFNGLBINDRENDERBUFFERPROC,        glBindRenderbuffer) \
+    X(PFNGLRENDERBUFFERSTORAGEPROC,     glRenderbufferStorage) \
+    X(PFNGLFRAMEBUFFERRENDERBUFFERPROC, glFramebufferRenderbuffer) \
+    X(PFNGLMAPBUFFERPROC,               glMapBuffer) \
+    X(PFNGLUNMAPBUFFERPROC,             glUnmapBuffer) \
+    X(PFNGLDELETEBUFFERSPROC,           glDeleteBuffers) \
+    X(PFNGLFENCESYNCPROC,               glFenceSync) \
+    X(PFNGLCLIENTWAITSYNCPROC,          glClientWaitSync) \
+    X(PFNGLDELETESYNCPROC,              glDeleteSync)
+
+#define X(type, name) extern type p##name;
+GL_FUNCS(X)
+GL_INSTANCING_FUNCS(X)
+GL_CAPTURE_FUNCS(X)
+#undef X
+
+#define glGenBuffers                pglGenBuffers
+#define glBindBuffer                pglBindBuffer
+#define glBufferData                pglBufferData
+#define glBufferSubData             pglBufferSubData
+
+#define glCreateShader              pglCreateShader
+#define glShaderSource              pglShaderSource
+#define glCompileShader             pglCompileShader
+#define glGetShaderiv               pglGetShaderiv
+#define glGetShaderInfoLog          pglGetShaderInfoLog
+#define glDeleteShader              pglDeleteShader
+#define glCreateProgram             pglCreateProgram
+#define glAttachShader              pglAttachShader
+#define glBindAttribLocation        pglBindAttribLocation
+#define glLinkProgram               pglLinkProgram
+#define glGetProgramiv              pglGetProgramiv
+#define glGetProgramInfoLog         pglGetProgramInfoLog
+#define glDeleteProgram             pglDeleteProgram
+#define glUseProgram                pglUseProgram
+#define glGetUniformLocation        pglGetUniformLocation
+#define glUniform1i                 pglUniform1i
+#define glUniform1f                 pglUniform1f
+#define glUniform2f                 pglUniform2f
+#define glUniform4fv                pglUniform4fv
+#define glVertexAttribPointer       pglVertexAttribPointer
+#define glEnableVertexAttribArray   pglEnableVertexAttribArray
+#define glDisableVertexAttribArray  pglDisableVertexAttribArray
+#define glVertexAttribDivisor       pglVertexAttribDivisor
+#define glDrawArraysInstanced       pglDrawArraysInstanced
+
+#define glGenFramebuffers           pglGenFramebuffers
+#define glBindFramebuffer           pglBindFramebuffer
+#define glCheckFramebufferStatus    pglCheckFramebufferStatus
+#define glGenRenderbuffers          pglGenRenderbuffers
+#define glBindRenderbuffer          pglBindRenderbuffer
+#define glRenderbufferStorage       pglRenderbufferStorage
+#define glFramebufferRenderbuffer   pglFramebufferRenderbuffer
+#define glMapBuffer                 pglMapBuffer
+#define glUnmapBuffer               pglUnmapBuffer
+#define glDeleteBuffers             pglDeleteBuffers
+#define glFenceSync                 pglFenceSync
+#define glClientWaitSync            pglClientWaitSync
+#define glDeleteSync                pglDeleteSync
+
+const char *gl_load(void);
+       int  gl_load_instancing(void);
+       int  gl_load_capture(void);
+
+#endif // GLFUNCS_H
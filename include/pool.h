@@ -0,0 +1,17 @@
+#ifndef POOL_H
+#define POOL_H
+
+#define POOL_MAX_THREADS 64
+
+// fixed set of worker threads that run one function together
+typedef struct Pool Pool;
+
+// runs on every worker of a pool, see pool_run
+typedef void (*PoolFn)(void *arg, int worker, int workers);
+
+Pool *pool_start(int threads, int pin);
+ int  pool_size(const Pool *p);
+void  pool_run(Pool *p, PoolFn fn, void *arg);
+void  pool_free(Pool *p);
+
+#endif // POOL_H
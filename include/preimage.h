@@ -0,0 +1,28 @@
+#ifndef PREIMAGE_H
+#define PREIMAGE_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+#include "automata.h"
+
+// rows that step to a given row, produced one at a time by preimage_next
+typedef struct {
+    int         rule;
+    Boundary    boundary;
+    size_t      width;
+    uint64_t   *row;            /* copy of the row whose preimages are listed */
+    uint16_t   *live;           /* width + 1 sets of nodes that can still finish */
+    uint64_t   *cells;          /* current preimage, width + 1 bits, see preimage_next */
+    int         start;          /* node the current preimage starts from, -1 before the first */
+} Preimages;
+
+     int  preimage_exists(int rule, Boundary boundary, const uint64_t *row, size_t width);
+uint64_t  preimage_count(int rule, Boundary boundary, const uint64_t *row, size_t width,
+                         double *log2_count);
+     int  preimages_init(Preimages *p, int rule, Boundary boundary, const uint64_t *row,
+                         size_t width);
+     int  preimage_next(Preimages *p);
+    void  preimages_free(Preimages *p);
+
+#endif // PREIMAGE_H
@@ -0,0 +1,26 @@
+#ifndef RECORDER_H
+#define RECORDER_H
+
+#include <stdint.h>
+
+// file formats, picked from the extension of the output path
+typedef enum { RECORD_GIF, RECORD_Y4M, RECORD_PPM } RecordFormat;
+
+// frames queued in a ring buffer and encoded on a writer thread
+typedef struct Recorder Recorder;
+
+// progress of a recording, see recorder_status
+typedef struct {
+    uint64_t    written;        /* frames encoded so far */
+    uint64_t    dropped;        /* frames that found the queue full */
+    int         queued;         /* frames waiting to be encoded */
+    int         max_queued;     /* deepest the queue has been */
+    int         slots;          /* size of the queue */
+} RecordStatus;
+
+Recorder  *recorder_open(const char *path, int width, int height, int fps, int slots);
+     int   recorder_push(Recorder *r, const unsigned char *rgba, int wait);
+    void   recorder_status(Recorder *r, RecordStatus *status);
+     int   recorder_close(Recorder *r, RecordStatus *status);
+
+#endif // RECORDER_H
@@ -11,15 +11,47 @@
 // added just for simplicity in main function
 void handleEvents(void);
 
+// thumbnails kept in the texture next to the atlas, see r_set_thumb
+#define R_THUMB_SIZE    40
+#define R_THUMB_COUNT   256
+#define R_ICON_THUMB    1024
+
+// quads and clip rects recorded from the draw calls, see r_batch_begin
+typedef struct {
+    int         at;             /* quads drawn before the clip rect is set */
+    mu_Rect     rect;
+} r_BatchClip;
+
+typedef struct {
+    void        *quads;         /* four vertices per quad */
+    int          count, cap;
+    r_BatchClip *clips;
+    int          clip_count, clip_cap;
+} r_Batch;
+
+// receives captured frames, see r_capture_start
+typedef void (*r_CaptureFn)(const unsigned char *rgba, int width, int height, void *udata);
+
 void r_init(void);
+ int r_init_offscreen(void);
 void r_draw_rect(mu_Rect rect, mu_Color color);
 void r_draw_text(const char *text, mu_Vec2 pos, mu_Color color);
 void r_draw_icon(int id, mu_Rect rect, mu_Color color);
+void r_draw_cells(const unsigned char *states, int cols, int rows, int size,
+                  mu_Color dead, mu_Color live);
  int r_get_text_width(const char *text, int len);
  int r_get_text_height(void);
+void r_set_thumb(int slot, const unsigned char *alpha);
 void r_set_clip_rect(mu_Rect rect);
 void r_clear(mu_Color color);
 void r_present(void);
+void r_resize(int width, int height);
+void r_batch_begin(r_Batch *batch);
+ int r_batch_end(void);
+void r_batch_draw(const r_Batch *batch);
+void r_batch_free(r_Batch *batch);
+ int r_capture_start(r_CaptureFn fn, void *udata);
+void r_capture_stop(void);
 
 #endif
 
@@ -0,0 +1,278 @@
+// generated by tools/rulegen.c, do not edit
+
+// next state of 64 cells under each rule, the arguments must be parenthesized
+#define RULE_0(l, c, r) (0)
+#define RULE_1(l, c, r) (~(c | (r | l)))
+#define RULE_2(l, c, r) ((r & ~l) & ~c)
+#define RULE_3(l, c, r) (~(c | l))
+#define RULE_4(l, c, r) (c & ~(r | l))
+#define RULE_5(l, c, r) (~(r | l))
+#define RULE_6(l, c, r) ((r ^ c) & ~l)
+#define RULE_7(l, c, r) (~(l | (r & c)))
+#define RULE_8(l, c, r) (c & (r & ~l))
+#define RULE_9(l, c, r) (~(l | (r ^ c)))
+#define RULE_10(l, c, r) (r & ~l)
+#define RULE_11(l, c, r) (~(l | (c & ~r)))
+#define RULE_12(l, c, r) (c & ~l)
+#define RULE_13(l, c, r) ((c | (~r)) & ~l)
+#define RULE_14(l, c, r) ((r | c) & ~l)
+#define RULE_15(l, c, r) (~l)
+#define RULE_16(l, c, r) (l & ~(r | c))
+#define RULE_17(l, c, r) (~(r | c))
+#define RULE_18(l, c, r) ((r ^ l) & ~c)
+#define RULE_19(l, c, r) (~(c | (r & l)))
+#define RULE_20(l, c, r) ((c ^ l) & ~r)
+#define RULE_21(l, c, r) ((~r) & ~(c & l))
+#define RULE_22(l, c, r) ((c | (r & l)) ^ (r | l))
+#define RULE_23(l, c, r) ((l | (c ^ (~r))) ^ (r | c))
+#define RULE_24(l, c, r) ((c ^ l) & (r ^ l))
+#define RULE_25(l, c, r) ((c & ~(r & l)) ^ (~r))
+#define RULE_26(l, c, r) ((r ^ l) & ~(c & ~r))
+#define RULE_27(l, c, r) ((l | (~r)) ^ (r | c))
+#define RULE_28(l, c, r) ((c | (r & l)) ^ l)
+#define RULE_29(l, c, r) ((c | (~r)) ^ (c & l))
+#define RULE_30(l, c, r) ((r | c) ^ l)
+#define RULE_31(l, c, r) (~((r | c) & l))
+#define RULE_32(l, c, r) (l & (r & ~c))
+#define RULE_33(l, c, r) (~(c | (r ^ l)))
+#define RULE_34(l, c, r) (r & ~c)
+#define RULE_35(l, c, r) ((~c) & ~(l & ~r))
+#define RULE_36(l, c, r) ((c ^ l) & ~(r ^ l))
+#define RULE_37(l, c, r) ((~r) ^ (l & ~(r & c)))
+#define RULE_38(l, c, r) ((r ^ c) & ~(l & ~r))
+#define RULE_39(l, c, r) ((c | (~r)) ^ (r | l))
+#define RULE_40(l, c, r) ((c ^ l) & r)
+#define RULE_41(l, c, r) ((l | (c & ~r)) ^ (c | (~r)))
+#define RULE_42(l, c, r) (r & ~(c & l))
+#define RULE_43(l, c, r) ((l | (~r)) ^ (c | (r ^ l)))
+#define RULE_44(l, c, r) ((r | c) & (c ^ l))
+#define RULE_45(l, c, r) ((c | (~r)) ^ l)
+#define RULE_46(l, c, r) ((c | (r ^ l)) ^ l)
+#define RULE_47(l, c, r) ((~l) | (r & ~c))
+#define RULE_48(l, c, r) (l & ~c)
+#define RULE_49(l, c, r) (~(c | (r & ~l)))
+#define RULE_50(l, c, r) ((r | l) & ~c)
+#define RULE_51(l, c, r) (~c)
+#define RULE_52(l, c, r) (l ^ (c & ~(r & ~l)))
+#define RULE_53(l, c, r) ((l | (~r)) ^ (c & l))
+#define RULE_54(l, c, r) (c ^ (r | l))
+#define RULE_55(l, c, r) (~(c & (r | l)))
+#define RULE_56(l, c, r) (l ^ (c & (r | l)))
+#define RULE_57(l, c, r) ((l | (~r)) ^ c)
+#define RULE_58(l, c, r) ((l | (r ^ c)) ^ c)
+#define RULE_59(l, c, r) ((r & ~l) | (~c))
+#define RULE_60(l, c, r) (c ^ l)
+#define RULE_61(l, c, r) ((l | (~(r | c))) ^ c)
+#define RULE_62(l, c, r) ((c | (r & ~l)) ^ l)
+#define RULE_63(l, c, r) (~(c & l))
+#define RULE_64(l, c, r) (l & (c & ~r))
+#define RULE_65(l, c, r) ((~r) & ~(c ^ l))
+#define RULE_66(l, c, r) ((r ^ l) & ~(c ^ l))
+#define RULE_67(l, c, r) ((~l) ^ (c & ~(r & l)))
+#define RULE_68(l, c, r) (c & ~r)
+#define RULE_69(l, c, r) ((~r) & ~(l & ~c))
+#define RULE_70(l, c, r) ((c | (r & l)) ^ r)
+#define RULE_71(l, c, r) ((~(c | l)) | (c & ~r))
+#define RULE_72(l, c, r) (c & (r ^ l))
+#define RULE_73(l, c, r) ((c | (~r)) & ~(c ^ (r ^ l)))
+#define RULE_74(l, c, r) ((r | c) & (r ^ l))
+#define RULE_75(l, c, r) ((~l) ^ (c & ~r))
+#define RULE_76(l, c, r) (c & ~(r & l))
+#define RULE_77(l, c, r) ((~(r | l)) | (c & (r ^ l)))
+#define RULE_78(l, c, r) ((r | c) ^ (r & l))
+#define RULE_79(l, c, r) ((~l) | (c & ~r))
+#define RULE_80(l, c, r) (l & ~r)
+#define RULE_81(l, c, r) ((l | (~c)) & ~r)
+#define RULE_82(l, c, r) ((l | (r & c)) ^ r)
+#define RULE_83(l, c, r) ((l | (~c)) ^ (r & l))
+#define RULE_84(l, c, r) ((c | l) & ~r)
+#define RULE_85(l, c, r) (~r)
+#define RULE_86(l, c, r) ((c | l) ^ r)
+#define RULE_87(l, c, r) (~((c | l) & r))
+#define RULE_88(l, c, r) ((l | (r & ~c)) ^ r)
+#define RULE_89(l, c, r) ((l | (~c)) ^ r)
+#define RULE_90(l, c, r) (r ^ l)
+#define RULE_91(l, c, r) ((l | (~(r | c))) ^ r)
+#define RULE_92(l, c, r) ((l | (r ^ c)) ^ r)
+#define RULE_93(l, c, r) ((c & ~l) | (~r))
+#define RULE_94(l, c, r) ((l | (c & ~r)) ^ r)
+#define RULE_95(l, c, r) (~(r & l))
+#define RULE_96(l, c, r) (l & (r ^ c))
+#define RULE_97(l, c, r) ((l | (~c)) & ~(c ^ (r ^ l)))
+#define RULE_98(l, c, r) ((r | l) & (r ^ c))
+#define RULE_99(l, c, r) ((~c) ^ (l & ~r))
+#define RULE_100(l, c, r) ((c | (r & ~l)) ^ r)
+#define RULE_101(l, c, r) ((l & ~c) ^ (~r))
+#define RULE_102(l, c, r) (r ^ c)
+#define RULE_103(l, c, r) ((~(c | l)) | (r ^ c))
+#define RULE_104(l, c, r) ((r | c) & ~(c ^ (r ^ l)))
+#define RULE_105(l, c, r) (l ^ (c ^ (~r)))
+#define RULE_106(l, c, r) (r ^ (c & l))
+#define RULE_107(l, c, r) (l ^ ((c | (r & ~l)) ^ (~r)))
+#define RULE_108(l, c, r) (c ^ (r & l))
+#define RULE_109(l, c, r) ((l | (c & ~r)) ^ (c ^ (~r)))
+#define RULE_110(l, c, r) ((r & ~l) | (r ^ c))
+#define RULE_111(l, c, r) ((~l) | (r ^ c))
+#define RULE_112(l, c, r) (l & ~(r & c))
+#define RULE_113(l, c, r) ((l | (~(r | c))) & ~(r & c))
+#define RULE_114(l, c, r) ((r | l) ^ (r & c))
+#define RULE_115(l, c, r) ((~c) | (l & ~r))
+#define RULE_116(l, c, r) ((c | (r ^ l)) ^ r)
+#define RULE_117(l, c, r) ((l & ~c) | (~r))
+#define RULE_118(l, c, r) ((l & ~c) | (r ^ c))
+#define RULE_119(l, c, r) (~(r & c))
+#define RULE_120(l, c, r) (l ^ (r & c))
+#define RULE_121(l, c, r) ((l | (~(r | c))) ^ (r & c))
+#define RULE_122(l, c, r) ((r & ~c) | (r ^ l))
+#define RULE_123(l, c, r) ((~c) | (r ^ l))
+#define RULE_124(l, c, r) ((c ^ l) | (c & ~r))
+#define RULE_125(l, c, r) ((c ^ l) | (~r))
+#define RULE_126(l, c, r) ((c ^ l) | (r ^ l))
+#define RULE_127(l, c, r) (~(c & (r & l)))
+#define RULE_128(l, c, r) (c & (r & l))
+#define RULE_129(l, c, r) (~((c ^ l) | (r ^ l)))
+#define RULE_130(l, c, r) (r & ~(c ^ l))
+#define RULE_131(l, c, r) ((~c) ^ (l & ~(c & ~r)))
+#define RULE_132(l, c, r) (c & ~(r ^ l))
+#define RULE_133(l, c, r) ((c | (~r)) & ~(r ^ l))
+#define RULE_134(l, c, r) ((r | c) & (c ^ (r ^ l)))
+#define RULE_135(l, c, r) ((~l) ^ (r & c))
+#define RULE_136(l, c, r) (r & c)
+#define RULE_137(l, c, r) ((~c) ^ ((l & ~c) | r))
+#define RULE_138(l, c, r) (r & ~(l & ~c))
+#define RULE_139(l, c, r) ((c | (r ^ l)) ^ (~r))
+#define RULE_140(l, c, r) (c & ~(l & ~r))
+#define RULE_141(l, c, r) ((~(r | l)) | (r & c))
+#define RULE_142(l, c, r) ((r & ~l) | (c & ~(r ^ l)))
+#define RULE_143(l, c, r) ((~l) | (r & c))
+#define RULE_144(l, c, r) (l & ~(r ^ c))
+#define RULE_145(l, c, r) ((l | (~c)) & ~(r ^ c))
+#define RULE_146(l, c, r) ((l | (c & ~r)) ^ (r ^ c))
+#define RULE_147(l, c, r) ((~c) ^ (r & l))
+#define RULE_148(l, c, r) ((c | (r & ~l)) ^ (r ^ l))
+#define RULE_149(l, c, r) ((~r) ^ (c & l))
+#define RULE_150(l, c, r) (c ^ (r ^ l))
+#define RULE_151(l, c, r) ((l | (~(r | c))) ^ (r ^ c))
+#define RULE_152(l, c, r) ((r | l) & ~(r ^ c))
+#define RULE_153(l, c, r) (c ^ (~r))
+#define RULE_154(l, c, r) ((l & ~c) ^ r)
+#define RULE_155(l, c, r) ((c | (r & ~l)) ^ (~r))
+#define RULE_156(l, c, r) ((l & ~r) ^ c)
+#define RULE_157(l, c, r) ((c & ~l) | (c ^ (~r)))
+#define RULE_158(l, c, r) ((l | (r & c)) ^ (r ^ c))
+#define RULE_159(l, c, r) (~(l & (r ^ c)))
+#define RULE_160(l, c, r) (r & l)
+#define RULE_161(l, c, r) ((l | (~c)) & ~(r ^ l))
+#define RULE_162(l, c, r) (r & ~(c & ~l))
+#define RULE_163(l, c, r) ((l | (~c)) ^ (l & ~r))
+#define RULE_164(l, c, r) ((r | c) & ~(r ^ l))
+#define RULE_165(l, c, r) (l ^ (~r))
+#define RULE_166(l, c, r) ((c & ~l) ^ r)
+#define RULE_167(l, c, r) ((l | (r & ~c)) ^ (~r))
+#define RULE_168(l, c, r) ((c | l) & r)
+#define RULE_169(l, c, r) ((c | l) ^ (~r))
+#define RULE_170(l, c, r) (r)
+#define RULE_171(l, c, r) ((~(c | l)) | r)
+#define RULE_172(l, c, r) ((c | l) ^ (l & ~r))
+#define RULE_173(l, c, r) ((l | (r & c)) ^ (~r))
+#define RULE_174(l, c, r) ((c & ~l) | r)
+#define RULE_175(l, c, r) ((~l) | r)
+#define RULE_176(l, c, r) (l & ~(c & ~r))
+#define RULE_177(l, c, r) ((l | (~r)) ^ (c & ~r))
+#define RULE_178(l, c, r) ((l | (r & ~c)) & ~(c & ~r))
+#define RULE_179(l, c, r) ((~c) | (r & l))
+#define RULE_180(l, c, r) (l ^ (c & ~r))
+#define RULE_181(l, c, r) ((l & ~c) | (l ^ (~r)))
+#define RULE_182(l, c, r) ((c | (r & l)) ^ (r ^ l))
+#define RULE_183(l, c, r) (~(c & (r ^ l)))
+#define RULE_184(l, c, r) (l ^ (c & (r ^ l)))
+#define RULE_185(l, c, r) ((c | (r & l)) ^ (~r))
+#define RULE_186(l, c, r) ((l & ~c) | r)
+#define RULE_187(l, c, r) ((~c) | r)
+#define RULE_188(l, c, r) (l ^ (c & ~(r & l)))
+#define RULE_189(l, c, r) ((c ^ l) | (c ^ (~r)))
+#define RULE_190(l, c, r) ((c ^ l) | r)
+#define RULE_191(l, c, r) (~(l & (c & ~r)))
+#define RULE_192(l, c, r) (c & l)
+#define RULE_193(l, c, r) ((c | (~r)) & ~(c ^ l))
+#define RULE_194(l, c, r) ((r | c) & ~(c ^ l))
+#define RULE_195(l, c, r) (l ^ (~c))
+#define RULE_196(l, c, r) (c & ~(r & ~l))
+#define RULE_197(l, c, r) ((l | (~r)) ^ (l & ~c))
+#define RULE_198(l, c, r) (c ^ (r & ~l))
+#define RULE_199(l, c, r) ((l | (c & ~r)) ^ (~c))
+#define RULE_200(l, c, r) (c & (r | l))
+#define RULE_201(l, c, r) ((r | l) ^ (~c))
+#define RULE_202(l, c, r) ((r | l) ^ (l & ~c))
+#define RULE_203(l, c, r) ((l | (r & c)) ^ (~c))
+#define RULE_204(l, c, r) (c)
+#define RULE_205(l, c, r) ((~(r | l)) | c)
+#define RULE_206(l, c, r) (c | (r & ~l))
+#define RULE_207(l, c, r) ((~l) | c)
+#define RULE_208(l, c, r) (l & ~(r & ~c))
+#define RULE_209(l, c, r) ((c | (~r)) ^ (c & ~l))
+#define RULE_210(l, c, r) (l ^ (r & ~c))
+#define RULE_211(l, c, r) (~((r | c) & (c ^ l)))
+#define RULE_212(l, c, r) ((c | (r ^ l)) ^ (r & ~l))
+#define RULE_213(l, c, r) ((~r) | (c & l))
+#define RULE_214(l, c, r) ((l | (c & ~r)) ^ (r & ~c))
+#define RULE_215(l, c, r) (~((c ^ l) & r))
+#define RULE_216(l, c, r) ((r | l) ^ (r & ~c))
+#define RULE_217(l, c, r) ((l & ~r) | (c ^ (~r)))
+#define RULE_218(l, c, r) ((r ^ l) | (r & c))
+#define RULE_219(l, c, r) ((r ^ l) | (c ^ (~r)))
+#define RULE_220(l, c, r) ((l & ~r) | c)
+#define RULE_221(l, c, r) (c | (~r))
+#define RULE_222(l, c, r) (c | (r ^ l))
+#define RULE_223(l, c, r) (~(l & (r & ~c)))
+#define RULE_224(l, c, r) ((r | c) & l)
+#define RULE_225(l, c, r) (l ^ (~(r | c)))
+#define RULE_226(l, c, r) ((r | c) ^ (c & ~l))
+#define RULE_227(l, c, r) (l ^ (~(c | (r & l))))
+#define RULE_228(l, c, r) ((r | c) ^ (r & ~l))
+#define RULE_229(l, c, r) ((c & ~r) | (l ^ (~r)))
+#define RULE_230(l, c, r) ((c & ~(r & l)) ^ r)
+#define RULE_231(l, c, r) ((r ^ c) | (l ^ (~r)))
+#define RULE_232(l, c, r) ((c | (r & l)) & (r | l))
+#define RULE_233(l, c, r) ((l | (r & c)) ^ (~(r | c)))
+#define RULE_234(l, c, r) (r | (c & l))
+#define RULE_235(l, c, r) (r | (l ^ (~c)))
+#define RULE_236(l, c, r) (c | (r & l))
+#define RULE_237(l, c, r) ((l ^ (~r)) | c)
+#define RULE_238(l, c, r) (r | c)
+#define RULE_239(l, c, r) ((~l) | (r | c))
+#define RULE_240(l, c, r) (l)
+#define RULE_241(l, c, r) (l | (~(r | c)))
+#define RULE_242(l, c, r) (l | (r & ~c))
+#define RULE_243(l, c, r) (l | (~c))
+#define RULE_244(l, c, r) (l | (c & ~r))
+#define RULE_245(l, c, r) (l | (~r))
+#define RULE_246(l, c, r) (l | (r ^ c))
+#define RULE_247(l, c, r) (~(c & (r & ~l)))
+#define RULE_248(l, c, r) (l | (r & c))
+#define RULE_249(l, c, r) (l | (c ^ (~r)))
+#define RULE_250(l, c, r) (r | l)
+#define RULE_251(l, c, r) ((l | (~c)) | r)
+#define RULE_252(l, c, r) (c | l)
+#define RULE_253(l, c, r) ((c | (~r)) | l)
+#define RULE_254(l, c, r) (c | (r | l))
+#define RULE_255(l, c, r) (~0)
+
+// X(n) for every rule
+#define FOR_EACH_RULE(X) \
+    X(0) X(1) X(2) X(3) X(4) X(5) X(6) X(7) X(8) X(9) X(10) X(11) X(12) X(13) X(14) X(15) \
+    X(16) X(17) X(18) X(19) X(20) X(21) X(22) X(23) X(24) X(25) X(26) X(27) X(28) X(29) X(30) X(31) \
+    X(32) X(33) X(34) X(35) X(36) X(37) X(38) X(39) X(40) X(41) X(42) X(43) X(44) X(45) X(46) X(47) \
+    X(48) X(49) X(50) X(51) X(52) X(53) X(54) X(55) X(56) X(57) X(58) X(59) X(60) X(61) X(62) X(63) \
+    X(64) X(65) X(66) X(67) X(68) X(69) X(70) X(71) X(72) X(73) X(74) X(75) X(76) X(77) X(78) X(79) \
+    X(80) X(81) X(82) X(83) X(84) X(85) X(86) X(87) X(88) X(89) X(90) X(91) X(92) X(93) X(94) X(95) \
+    X(96) X(97) X(98) X(99) X(100) X(101) X(102) X(103) X(104) X(105) X(106) X(107) X(108) X(109) X(110) X(111) \
+    X(112) X(113) X(114) X(115) X(116) X(117) X(118) X(119) X(120) X(121) X(122) X(123) X(124) X(125) X(126) X(127) \
+    X(128) X(129) X(130) X(131) X(132) X(133) X(134) X(135) X(136) X(137) X(138) X(139) X(140) X(141) X(142) X(143) \
+    X(144) X(145) X(146) X(147) X(148) X(149) X(150) X(151) X(152) X(153) X(154) X(155) X(156) X(157) X(158) X(159) \
+    X(160) X(161) X(162) X(163) X(164) X(165) X(166) X(167) X(168) X(169) X(170) X(171) X(172) X(173) X(174) X(175) \
+    X(176) X(177) X(178) X(179) X(180) X(181) X(182) X(183) X(184) X(185) X(186) X(187) X(188) X(189) X(190) X(191) \
+    X(192) X(193) X(194) X(195) X(196) X(197) X(198) X(199) X(200) X(201) X(202) X(203) X(204) X(205) X(206) X(207) \
+    X(208) X(209) X(210) X(211) X(212) X(213) X(214) X(215) X(216) X(217) X(218) X(219) X(220) X(221) X(222) X(223) \
+    X(224) X(225) X(226) X(227) X(228) X(229) X(230) X(231) X(232) X(233) X(234) X(235) X(236) X(237) X(238) X(239) \
+    X(240) X(241) X(242) X(243) X(244) X(245) X(246) X(247) X(248) X(249) X(250) X(251) X(252) X(253) X(254) X(255)
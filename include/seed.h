@@ -0,0 +1,37 @@
+#ifndef SEED_H
+#define SEED_H
+
+#include <stddef.h>
+#include <stdint.h>
+
+// initial condition generators
+typedef enum {
+    SEED_SINGLE,            /* one live cell in the middle of the row */
+    SEED_RANDOM,            /* each cell live with probability density */
+    SEED_PATTERN,           /* text repeated across the whole row */
+    SEED_STRING,            /* text placed once in the middle of the row */
+    SEED_FILE,              /* contents of the file at text, like SEED_STRING */
+    SEED_COUNT
+} SeedKind;
+
+typedef struct {
+    SeedKind    kind;
+    double      density;
+    uint64_t    seed;
+    const char *text;
+} SeedSpec;
+
+// xoshiro256** generator, 64 random bits per call
+typedef struct { uint64_t s[4]; } Rng;
+
+void     rng_init(Rng *rng, uint64_t seed);
+uint64_t rng_next(Rng *rng);
+void     rng_bernoulli(Rng *rng, uint64_t *words, size_t count, double p);
+void     rng_bernoulli_at(uint64_t seed, uint64_t stream, uint64_t index,
+                          uint64_t *words, size_t count, double p);
+
+const char *seed_name(SeedKind kind);
+       int  seed_parse(SeedSpec *spec, const char *arg);
+       int  seed_fill(const SeedSpec *spec, uint64_t *words, size_t width);
+
+#endif // SEED_H
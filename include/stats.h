@@ -0,0 +1,45 @@
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdint.h>
+#include <stdio.h>
+
+// largest n for n-block counts, blocks up to STATS_TABLE_BLOCK use a table
+#define STATS_MAX_BLOCK     8
+#define STATS_TABLE_BLOCK   4
+
+// per generation statistics of a packed row, filled in while stepping
+typedef struct {
+    int         block;          /* n of the n-block counts, 0 for none */
+    uint64_t   *table;          /* packed block counts for each byte, see stats_init */
+    int         lanes;          /* words per table entry */
+
+    // results for the last row
+    uint64_t    cells;          /* cells in the row */
+    uint64_t    ones;           /* live cells */
+    uint64_t    left;           /* live cells in the left half of the row */
+    uint64_t    counts[1 << STATS_MAX_BLOCK];   /* occurrences of each n-block */
+
+    // progress through the row being collected
+    long long   lo, hi, mid;
+    long long   pending;        /* first word whose blocks aren't counted yet */
+    uint64_t    acc[(1 << STATS_TABLE_BLOCK) / 8];
+    int         acc_bytes;
+} Stats;
+
+   int  stats_init(Stats *s, int block);
+  void  stats_free(Stats *s);
+  void  stats_begin(Stats *s, long long lo, long long hi);
+  void  stats_words(Stats *s, const uint64_t *row, long long a, long long b);
+  void  stats_end(Stats *s, const uint64_t *row);
+  void  stats_part(Stats *part, const Stats *s, long long a);
+  void  stats_merge(Stats *s, Stats *part, const uint64_t *row);
+
+double  stats_density(const Stats *s);
+double  stats_entropy(const Stats *s);
+double  stats_asymmetry(const Stats *s);
+
+  void  stats_write_header(FILE *f, const Stats *s, int binary);
+  void  stats_write(FILE *f, const Stats *s, uint64_t generation, int binary);
+
+#endif // STATS_H
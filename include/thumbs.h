@@ -0,0 +1,17 @@
+#ifndef THUMBS_H
+#define THUMBS_H
+
+#define THUMB_RULES 256
+
+// thumbnails of every rule, drawn by worker threads
+typedef struct Thumbs Thumbs;
+
+// receives a finished thumbnail, see thumbs_poll
+typedef void (*ThumbFn)(int rule, const unsigned char *pixels, int size, void *udata);
+
+Thumbs *thumbs_start(int size, int threads);
+   int  thumbs_poll(Thumbs *t, ThumbFn fn, void *udata);
+   int  thumbs_pending(Thumbs *t);
+  void  thumbs_free(Thumbs *t);
+
+#endif // THUMBS_H
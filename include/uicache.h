@@ -0,0 +1,10 @@
+#ifndef UICACHE_H
+#define UICACHE_H
+
+#include "microui.h"
+
+// draws the commands of a finished frame, see ui_draw
+void ui_draw(mu_Context *ctx);
+void ui_free(void);
+
+#endif // UICACHE_H
@@ -0,0 +1,126 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "arena.h"
+
+#define ROUND_UP(n) (((n) + ARENA_ALIGN - 1) & ~(size_t)(ARENA_ALIGN - 1))
+
+// header at the start of each block, the data follows it aligned
+struct ArenaBlock {
+    ArenaBlock *prev;           /* blocks filled before this one */
+    size_t      size;           /* bytes of data */
+    size_t      used;
+};
+
+#define HEADER ROUND_UP(sizeof(ArenaBlock))
+
+static unsigned char *block_data(ArenaBlock *b) {
+    return (unsigned char *)b + HEADER;
+}
+
+/*
+ * Function:  arena_init
+ * --------------------
+ * sets up an empty arena, no memory is taken until the first allocation
+ *
+ *  block_size: bytes to take from the system at a time, more for larger
+ *              allocations
+ *
+ */
+void arena_init(Arena *a, size_t block_size) {
+    memset(a, 0, sizeof(*a));
+    a->block_size = ROUND_UP(block_size ? block_size : ARENA_ALIGN);
+}
+
+/*
+ * Function:  arena_alloc
+ * --------------------
+ * allocates size bytes aligned to ARENA_ALIGN. The memory stays valid
+ * until arena_reset and is not cleared.
+ *
+ *  returns: the memory, or NULL if out of memory
+ */
+void *arena_alloc(Arena *a, size_t size) {
+    ArenaBlock *b = a->block;
+    size = ROUND_UP(size ? size : 1);
+
+    if (!b || b->size - b->used < size) {
+        size_t data = size > a->block_size ? size : a->block_size;
+        b = aligned_alloc(ARENA_ALIGN, HEADER + data);
+        if (!b) return NULL;
+        b->prev = a->block;
+        b->size = data;
+        b->used = 0;
+        a->block = b;
+    }
+
+    a->last = block_data(b) + b->used;
+    b->used += size;
+    return a->last;
+}
+
+/*
+ * Function:  arena_grow
+ * --------------------
+ * resizes an allocation like realloc. The latest allocation grows in
+ * place while its block has room, anything else is copied to a new
+ * allocation and the old space is only reclaimed by arena_reset.
+ *
+ *  p:          allocation to grow, or NULL
+ *  old_size:   bytes of it to keep
+ *  size:       new size in bytes
+ *
+ *  returns: the allocation, or NULL if out of memory (p is still valid)
+ */
+void *arena_grow(Arena *a, void *p, size_t old_size, size_t size) {
+    ArenaBlock *b = a->block;
+
+    if (p && p == a->last) {
+        size_t at = (unsigned char *)p - block_data(b);
+        if (b->size - at >= ROUND_UP(size ? size : 1)) {
+            b->used = at + ROUND_UP(size ? size : 1);
+            return p;
+        }
+    }
+
+    void *q = arena_alloc(a, size);
+    if (q && p) memcpy(q, p, old_size < size ? old_size : size);
+    return q;
+}
+
+/*
+ * Function:  arena_reset
+ * --------------------
+ * frees everything allocated from the arena. When it took more than one
+ * block, they are returned and the next allocation takes a single block
+ * as large as all of them, so a run with the same needs fits in it.
+ *
+ */
+void arena_reset(Arena *a) {
+    ArenaBlock *b = a->block;
+    a->last = NULL;
+    if (!b) return;
+
+    if (!b->prev) {
+        b->used = 0;
+        return;
+    }
+
+    size_t total = 0;
+    while (b) {
+        ArenaBlock *prev = b->prev;
+        total += b->size;
+        free(b);
+        b = prev;
+    }
+    a->block = NULL;
+    if (total > a->block_size) a->block_size = total;
+}
+
+void arena_free(Arena *a) {
+    size_t block_size = a->block_size;
+    arena_reset(a);
+    free(a->block);
+    arena_init(a, block_size);
+}
+
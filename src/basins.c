@@ -0,0 +1,289 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "basins.h"
+#include "pool.h"
+#include "rules.inl"
+
+/*
+ * The graph is kept in two arrays of one 32 bit word per state. succ
+ * holds the successors. The other starts out as in-degrees, and states
+ * that can't be on a cycle are peeled off by repeatedly removing those
+ * without predecessors. The states left are exactly the cycle states,
+ * and after walking the cycles and then every transient path into them
+ * it holds the attractor of each state. A set top bit marks a state
+ * whose attractor is known; in-degrees never reach it since there are at
+ * most 2^30 states.
+ */
+#define REMOVED 0xffffffffu
+#define LABELED 0x80000000u
+
+/*
+ * ring_rule_<n> fills succ[from, to) for rule n. All the cells of a state
+ * are stepped at once, the neighbors are the state rotated by one cell
+ * either way.
+ */
+typedef void (*RingKernel)(uint32_t *succ, uint64_t from, uint64_t to, int cells);
+
+#define RING_KERNEL(n)                                                              \
+    static void ring_rule_##n(uint32_t *succ, uint64_t from, uint64_t to, int cells) { \
+        uint64_t mask = (1ull << cells) - 1;                                        \
+        for (uint64_t c = from; c < to; c++) {                                      \
+            uint64_t l = ((c << 1) | (c >> (cells - 1))) & mask;                    \
+            uint64_t r = ((c >> 1) | (c << (cells - 1))) & mask;                    \
+            succ[c] = (uint32_t)(RULE_##n((l), (c), (r)) & mask);                   \
+            (void)l;                                                                \
+            (void)r;                                                                \
+        }                                                                           \
+    }
+#define RING_KERNEL_ENTRY(n) ring_rule_##n,
+
+FOR_EACH_RULE(RING_KERNEL)
+
+static const RingKernel ring_kernels[256] = { FOR_EACH_RULE(RING_KERNEL_ENTRY) };
+
+// states [*from, *to) belong to worker k of n
+static void share(const Basins *b, int k, int n, uint64_t *from, uint64_t *to) {
+    *from = b->states * k / n;
+    *to = b->states * (k + 1) / n;
+}
+
+static void fill_succ(void *arg, int k, int n) {
+    Basins *b = arg;
+    uint64_t from, to;
+
+    share(b, k, n, &from, &to);
+    ring_kernels[b->rule](b->succ, from, to, b->cells);
+}
+
+// zeroes the in-degrees of a worker's share, before any worker counts
+static void clear_preds(void *arg, int k, int n) {
+    Basins *b = arg;
+    uint64_t from, to;
+
+    share(b, k, n, &from, &to);
+    memset(b->basin + from, 0, (to - from) * sizeof(uint32_t));
+}
+
+/*
+ * Function:  count_preds
+ * --------------------
+ * adds the states of a worker's share to the in-degrees of their
+ * successors. Successors can be anywhere, so with more than one worker
+ * the counts are added atomically, with the compiler's builtins on the
+ * plain array the later passes use. A run of states with the same
+ * successor is added at once so rules that send most states to a few
+ * don't make the workers fight over them.
+ *
+ */
+static void count_preds(void *arg, int k, int n) {
+    Basins *b = arg;
+    uint64_t from, to, s;
+    uint32_t last = 0, run = 0;
+
+    share(b, k, n, &from, &to);
+    if (n == 1) {
+        for (s = from; s < to; s++) b->basin[b->succ[s]]++;
+        return;
+    }
+
+    for (s = from; s < to; s++) {
+        uint32_t t = b->succ[s];
+        if (run && t != last) {
+            __atomic_fetch_add(b->basin + last, run, __ATOMIC_RELAXED);
+            run = 0;
+        }
+        last = t;
+        run++;
+    }
+    if (run) __atomic_fetch_add(b->basin + last, run, __ATOMIC_RELAXED);
+}
+
+// power of two bucket of an in-degree, see Basins.indegree
+static int bucket(uint32_t d) {
+    int k = 0;
+    while (d) {
+        d >>= 1;
+        k++;
+    }
+    return k;
+}
+
+/*
+ * Function:  peel
+ * --------------------
+ * removes every state that isn't on a cycle, following each chain of
+ * states left without predecessors as far as it goes
+ *
+ */
+static void peel(Basins *b) {
+    uint32_t *deg = b->basin;
+
+    for (uint64_t s = 0; s < b->states; s++) {
+        uint32_t x = (uint32_t)s;
+        while (deg[x] == 0) {
+            deg[x] = REMOVED;
+            x = b->succ[x];
+            deg[x]--;
+        }
+    }
+}
+
+/*
+ * Function:  label
+ * --------------------
+ * numbers the cycles by their smallest state and marks every state with
+ * the cycle it ends up on
+ *
+ *  returns: 0 on success, -1 if out of memory
+ */
+static int label(Basins *b) {
+    uint32_t *lab = b->basin, x, id;
+    uint64_t s, cap = 0;
+
+    for (s = 0; s < b->states; s++) {
+        if (lab[s] == REMOVED || (lab[s] & LABELED)) continue;
+
+        if (b->cycles == cap) {
+            cap = cap ? 2 * cap : 64;
+            BasinCycle *cycle = realloc(b->cycle, cap * sizeof(BasinCycle));
+            if (!cycle) return -1;
+            b->cycle = cycle;
+        }
+        BasinCycle *c = &b->cycle[b->cycles];
+        c->state = (uint32_t)s;
+        c->period = 0;
+        c->basin = 0;
+        x = (uint32_t)s;
+        do {
+            lab[x] = LABELED | b->cycles;
+            x = b->succ[x];
+            c->period++;
+        } while (x != s);
+        b->cycle_states += c->period;
+        b->cycles++;
+    }
+
+    for (s = 0; s < b->states; s++) {
+        if (lab[s] != REMOVED) continue;
+        for (x = (uint32_t)s; lab[x] == REMOVED; x = b->succ[x]) {}
+        id = lab[x];
+        for (x = (uint32_t)s; lab[x] == REMOVED; x = b->succ[x]) lab[x] = id;
+    }
+
+    for (s = 0; s < b->states; s++) {
+        lab[s] &= ~LABELED;
+        b->cycle[lab[s]].basin++;
+    }
+    return 0;
+}
+
+/*
+ * Function:  basins_compute
+ * --------------------
+ * maps where every state of a ring goes under a rule: its successor,
+ * the cycle it falls into, the period and basin size of each cycle and
+ * how many predecessors states have. Needs 8 bytes per state and 12 per
+ * cycle.
+ *
+ *  rule:       elementary rule 0-255
+ *  cells:      ring size 1 to BASINS_MAX_CELLS
+ *  threads:    workers for the successors and in-degrees, 0 for one per CPU
+ *
+ *  returns: 0 on success, -1 on bad arguments or if out of memory
+ */
+int basins_compute(Basins *b, int rule, int cells, int threads) {
+    memset(b, 0, sizeof(*b));
+    if (rule < 0 || rule > 255 || cells < 1 || cells > BASINS_MAX_CELLS) return -1;
+
+    b->rule = rule;
+    b->cells = cells;
+    b->states = 1ull << cells;
+    b->succ = malloc(b->states * sizeof(uint32_t));
+    b->basin = malloc(b->states * sizeof(uint32_t));
+    if (!b->succ || !b->basin) {
+        basins_free(b);
+        return -1;
+    }
+
+    Pool *pool = threads == 1 ? NULL : pool_start(threads, 0);
+    if (pool) {
+        pool_run(pool, fill_succ, b);
+        pool_run(pool, clear_preds, b);
+        pool_run(pool, count_preds, b);
+        pool_free(pool);
+    } else {
+        fill_succ(b, 0, 1);
+        clear_preds(b, 0, 1);
+        count_preds(b, 0, 1);
+    }
+
+    for (uint64_t s = 0; s < b->states; s++) {
+        uint32_t d = b->basin[s];
+        b->indegree[bucket(d)]++;
+        if (d > b->max_indegree) b->max_indegree = d;
+    }
+
+    peel(b);
+    if (label(b)) {
+        basins_free(b);
+        return -1;
+    }
+    return 0;
+}
+
+void basins_free(Basins *b) {
+    free(b->succ);
+    free(b->basin);
+    free(b->cycle);
+    b->succ = b->basin = NULL;
+    b->cycle = NULL;
+}
+
+static int by_period_and_basin(const void *pa, const void *pb) {
+    const BasinCycle *a = pa, *b = pb;
+    if (a->period != b->period) return a->period < b->period ? -1 : 1;
+    if (a->basin != b->basin)   return a->basin < b->basin ? -1 : 1;
+    if (a->state != b->state)   return a->state < b->state ? -1 : 1;
+    return 0;
+}
+
+/*
+ * Function:  basins_write
+ * --------------------
+ * prints a summary: the totals, the in-degrees in power of two buckets,
+ * and one line per period and basin size with the number of cycles that
+ * have them
+ *
+ */
+void basins_write(FILE *f, const Basins *b) {
+    uint32_t i, j;
+    int k;
+
+    fprintf(f, "rule %d ring %d: %llu states, %u cycles on %llu states, "
+               "%llu without predecessors, in-degree up to %u\n",
+            b->rule, b->cells, (unsigned long long)b->states, b->cycles,
+            (unsigned long long)b->cycle_states, (unsigned long long)b->indegree[0],
+            b->max_indegree);
+
+    fprintf(f, "  in-degree");
+    for (k = 0; k <= bucket(b->max_indegree); k++) {
+        if (!b->indegree[k]) continue;
+        if (k < 2) fprintf(f, " %d:%llu", k, (unsigned long long)b->indegree[k]);
+        else       fprintf(f, " %u-%u:%llu", 1u << (k - 1), (1u << (k - 1)) * 2 - 1,
+                           (unsigned long long)b->indegree[k]);
+    }
+    fprintf(f, "\n");
+
+    BasinCycle *sorted = malloc(b->cycles * sizeof(BasinCycle));
+    if (!sorted) return;
+    memcpy(sorted, b->cycle, b->cycles * sizeof(BasinCycle));
+    qsort(sorted, b->cycles, sizeof(BasinCycle), by_period_and_basin);
+    for (i = 0; i < b->cycles; i = j) {
+        for (j = i + 1; j < b->cycles && sorted[j].period == sorted[i].period
+                                     && sorted[j].basin == sorted[i].basin; j++) {}
+        fprintf(f, "  %u x period %u with a basin of %u states, the first through state %u\n",
+                j - i, sorted[i].period, sorted[i].basin, sorted[i].state);
+    }
+    free(sorted);
+}
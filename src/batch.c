@@ -0,0 +1,184 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "batch.h"
+#include "rules.inl"
+
+/*
+ * With the rows sliced across the bits of each word, the neighbors of
+ * cell x in all 64 rows are simply the words x - 1 and x + 1, so a
+ * generation is one formula per word with no shifts, and the loop has no
+ * dependency between words for the compiler to trip over when it
+ * vectorizes it. slice_rule_<n> uses the same minimized formulas as the
+ * engine's kernels.
+ */
+typedef void (*SliceKernel)(const uint64_t *src, uint64_t *dst, size_t width);
+
+#define SLICE_KERNEL(n)                                                         \
+    static void slice_rule_##n(const uint64_t *src, uint64_t *dst, size_t width) { \
+        for (size_t x = 1; x <= width; x++)                                     \
+            dst[x] = RULE_##n((src[x - 1]), (src[x]), (src[x + 1]));            \
+    }
+#define SLICE_KERNEL_ENTRY(n) slice_rule_##n,
+
+FOR_EACH_RULE(SLICE_KERNEL)
+
+static const SliceKernel slice_kernels[256] = { FOR_EACH_RULE(SLICE_KERNEL_ENTRY) };
+
+/*
+ * Function:  transpose64
+ * --------------------
+ * transposes a 64 x 64 bit matrix in place, bit j of m[i] swaps with
+ * bit i of m[j]. Swaps blocks of half the size at each of six levels.
+ *
+ */
+static void transpose64(uint64_t m[64]) {
+    uint64_t mask = 0x00000000ffffffffull;
+    for (int s = 32; s; s >>= 1, mask ^= mask << s) {
+        for (int i = 0; i < 64; i = (i + s + 1) & ~s) {
+            uint64_t t = ((m[i] >> s) ^ m[i + s]) & mask;
+            m[i] ^= t << s;
+            m[i + s] ^= t;
+        }
+    }
+}
+
+/*
+ * Function:  batch_init
+ * --------------------
+ * creates 64 empty rows
+ *
+ *  rule:       elementary rule 0-255
+ *  width:      cells per row
+ *  boundary:   any boundary but BOUNDARY_GROW
+ *
+ *  returns: 0 on success, -1 on bad arguments or if out of memory
+ */
+int batch_init(Batch *b, int rule, size_t width, Boundary boundary) {
+    memset(b, 0, sizeof(*b));
+    if (width == 0 || rule < 0 || rule > 255 || boundary == BOUNDARY_GROW) return -1;
+
+    b->rule = rule;
+    b->boundary = boundary;
+    b->width = width;
+    b->cells = calloc(width + 2, sizeof(uint64_t));
+    b->next = calloc(width + 2, sizeof(uint64_t));
+    if (!b->cells || !b->next) {
+        batch_free(b);
+        return -1;
+    }
+    return 0;
+}
+
+void batch_free(Batch *b) {
+    free(b->cells);
+    free(b->next);
+    b->cells = b->next = NULL;
+}
+
+/*
+ * Function:  batch_seed
+ * --------------------
+ * replaces one row with a freshly generated one, the other rows keep
+ * their cells
+ *
+ *  row:        row to seed 0-63
+ *
+ *  returns: result of seed_fill, or -1 if out of memory
+ */
+int batch_seed(Batch *b, int row, const SeedSpec *spec) {
+    uint64_t *words = malloc((b->width + 63) / 64 * sizeof(uint64_t));
+    uint64_t bit = 1ull << row;
+    size_t x;
+
+    if (!words) return -1;
+    int res = seed_fill(spec, words, b->width);
+    for (x = 0; x < b->width; x++) {
+        if ((words[x / 64] >> (x % 64)) & 1) b->cells[x + 1] |= bit;
+        else                                 b->cells[x + 1] &= ~bit;
+    }
+    free(words);
+    b->generation = 0;
+    return res;
+}
+
+/*
+ * Function:  batch_seed_all
+ * --------------------
+ * seeds every row, row j with spec's generator started from seed
+ * spec->seed + j, so random rows are independent and reproducible. The
+ * rows are generated packed and turned into slices 64 cells at a time.
+ *
+ *  returns: 0 on success, else the first failing result of seed_fill or
+ *           -1 if out of memory
+ */
+int batch_seed_all(Batch *b, const SeedSpec *spec) {
+    size_t nwords = (b->width + 63) / 64, w, x;
+    uint64_t *rows = malloc(BATCH_ROWS * nwords * sizeof(uint64_t));
+    uint64_t block[64];
+    int j, res = 0;
+
+    if (!rows) return -1;
+    for (j = 0; j < BATCH_ROWS; j++) {
+        SeedSpec s = *spec;
+        s.seed += j;
+        if (!res) res = seed_fill(&s, rows + j * nwords, b->width);
+    }
+
+    for (w = 0; w < nwords; w++) {
+        for (j = 0; j < BATCH_ROWS; j++) block[j] = rows[j * nwords + w];
+        transpose64(block);
+        for (x = w * 64; x < b->width && x < w * 64 + 64; x++) b->cells[x + 1] = block[x % 64];
+    }
+    free(rows);
+    b->generation = 0;
+    return res;
+}
+
+/*
+ * Function:  batch_step
+ * --------------------
+ * advances all 64 rows by one generation
+ *
+ */
+void batch_step(Batch *b) {
+    uint64_t *c = b->cells, *tmp;
+    size_t n = b->width;
+
+    switch (b->boundary) {
+        case BOUNDARY_FIXED0:  c[0] = 0;     c[n + 1] = 0;    break;
+        case BOUNDARY_FIXED1:  c[0] = ~0ull; c[n + 1] = ~0ull; break;
+        case BOUNDARY_REFLECT: c[0] = c[1];  c[n + 1] = c[n]; break;
+        default:               c[0] = c[n];  c[n + 1] = c[1]; break;
+    }
+    slice_kernels[b->rule](c, b->next, n);
+
+    tmp = b->cells;
+    b->cells = b->next;
+    b->next = tmp;
+    b->generation++;
+}
+
+/*
+ * Function:  batch_extract
+ * --------------------
+ * copies one row out in the packed layout of the engine and seed_fill
+ *
+ *  row:        row to copy 0-63
+ *  words:      (width + 63) / 64 words, bit x % 64 of words[x / 64] is cell x
+ *
+ */
+void batch_extract(const Batch *b, int row, uint64_t *words) {
+    size_t x;
+
+    memset(words, 0, (b->width + 63) / 64 * sizeof(uint64_t));
+    for (x = 0; x < b->width; x++)
+        words[x / 64] |= ((b->cells[x + 1] >> row) & 1) << (x % 64);
+}
+
+/*
+ *  returns: state of cell x of a row
+ */
+int batch_get(const Batch *b, int row, size_t x) {
+    return (b->cells[x + 1] >> row) & 1;
+}
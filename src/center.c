@@ -0,0 +1,77 @@
+#include <stdlib.h>
+
+#include "center.h"
+#include "engine.h"
+
+// bytes buffered before they're written out
+#define OUT_BYTES 4096
+
+/*
+ * Function:  center_column
+ * --------------------
+ * writes the centre cell of every generation of an unbounded row (rule 30
+ * from a single cell is the classic generator), eight generations per
+ * byte with the first one in the most significant bit. A last byte that
+ * isn't full is padded with zeros.
+ *
+ * Only cells in the light cone of the seed are stored, and when the number
+ * of bits is known the row is also cropped to the cells that can still
+ * reach the centre by the last generation, so generation t costs
+ * min(t, bits - t) words of work instead of the width of a fixed row.
+ *
+ *  rule:       elementary rule 0-255
+ *  spec:       initial row
+ *  width:      cells in the initial row, the centre is cell width / 2
+ *  bits:       number of bits to write, 0 to go on until writing fails
+ *  out:        stream for the bytes, or NULL to only compute them
+ *
+ *  returns: number of bits written, not counting the padding
+ */
+uint64_t center_column(int rule, const SeedSpec *spec, size_t width, uint64_t bits, FILE *out) {
+    Engine e;
+    unsigned char *buf;
+    uint64_t t, written = 0;
+    long long c = (long long)width / 2;
+    size_t n = 0;
+    int byte = 0, pad = 0;
+
+    if (engine_init(&e, rule, width, BOUNDARY_GROW)) return 0;
+    buf = malloc(OUT_BYTES);
+    if (!buf || engine_seed(&e, spec)) {
+        free(buf);
+        engine_free(&e);
+        return 0;
+    }
+
+    for (t = 0; bits == 0 || t < bits; t++) {
+        if (t) engine_step(&e);
+
+        // cells further than r from the centre can't reach it in time
+        if (bits) {
+            long long r = (long long)(bits - 1 - t);
+            engine_crop(&e, c - r, c + r + 1);
+        }
+
+        byte = (byte << 1) | engine_get(&e, c);
+        if (t % 8 != 7) continue;
+
+        buf[n++] = (unsigned char)byte;
+        byte = 0;
+        if (n == OUT_BYTES) {
+            if (out && fwrite(buf, 1, n, out) != n) break;
+            written += 8 * n;
+            n = 0;
+        }
+    }
+
+    // all bits were made, the last few go out in a byte of their own
+    if (bits && t == bits && t % 8) {
+        pad = 8 - (int)(t % 8);
+        buf[n++] = (unsigned char)(byte << pad);
+    }
+    if (n && (!out || fwrite(buf, 1, n, out) == n)) written += 8 * n - pad;
+    if (out) fflush(out);
+    free(buf);
+    engine_free(&e);
+    return written;
+}
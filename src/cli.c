@@ -0,0 +1,817 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "basins.h"
+#include "batch.h"
+#include "center.h"
+#include "cli.h"
+#include "cycle.h"
+#include "engine.h"
+#include "preimage.h"
+#include "recorder.h"
+#include "seed.h"
+
+typedef struct {
+    int         rule;
+    size_t      width;
+    uint64_t    gens;
+    uint64_t    jump;           /* generation the run starts from */
+    Boundary    boundary;
+    SeedSpec    init;
+    const char *rule_map;       /* comma separated rules repeated across the row, or NULL */
+    int         mix_rule;       /* rule of the cells selected by mix, -1 for none */
+    SeedSpec    mix;
+    double      noise;          /* probability of a cell deviating from its rule */
+    int         noise_rule;     /* rule of the deviating cells, -1 to flip them */
+    int         second_order;   /* xor in the previous row, which starts as previous */
+    SeedSpec    previous;
+    int         reverse;        /* step back to the start after the run */
+    int         quiet;
+    int         bench;
+    int         cycles;         /* 1 to report cycles, 2 to also stop at one */
+    int         stats;          /* 1 for csv statistics, 2 for binary */
+    int         block;          /* n of the n-block statistics */
+    int         center;         /* write the centre column as raw bytes */
+    uint64_t    center_bits;    /* bits of it to write, 0 for no limit */
+    const char *record;         /* animation of the run, NULL for none */
+    int         scale;          /* pixels per cell in the animation */
+    int         fps;
+    int         preimages;      /* count the initial row's preimages */
+    uint64_t    preimages_max;  /* and print this many of them */
+    int         basins_from;    /* ring sizes to map exhaustively, 0 for none */
+    int         basins_to;
+    EngineOptions placement;    /* threads, huge pages and pinning of the row */
+} Options;
+
+// scrolling picture of the latest generations, one frame per generation
+typedef struct {
+    Recorder       *rec;
+    unsigned char  *pixels;
+    int             width, height;  /* in cells */
+    int             scale;
+    int             rows;           /* generations drawn so far, up to height */
+} Film;
+
+static const char *usage =
+    "usage: simulate [options]\n"
+    "Runs the automaton without a window and prints one row per line.\n"
+    "Without options the interactive viewer is started instead.\n"
+    "\n"
+    "  --rule N          elementary rule 0-255 (default 30)\n"
+    "  --rule-map LIST   give the cells their own rules, LIST is rules separated by\n"
+    "                    commas repeated across the row, e.g. 30,90 alternates\n"
+    "  --mix R:SPEC      cells live in the row SPEC (like --init, random ones use\n"
+    "                    the seed two after --seed) follow rule R, the rest --rule\n"
+    "  --noise P[:R]     each generation every cell is flipped with probability P,\n"
+    "                    or with :R follows rule R instead (noise is seeded with\n"
+    "                    the seed three after --seed, whatever --threads is)\n"
+    "  --width N         cells per row (default 80, 1e9 for --bench)\n"
+    "  --gens N          generations to run (default 40)\n"
+    "  --jump N          start from generation N, reached in O(width log N) for\n"
+    "                    rules 60, 90, 102, 150 and their complements\n"
+    "  --boundary MODE   periodic, fixed0, fixed1, reflect or grow (default periodic)\n"
+    "  --init SPEC       single, random[:P], pattern:CELLS, string:CELLS or file:PATH\n"
+    "                    (cells are 1 or # for live, anything else for dead)\n"
+    "  --seed N          seed for random initial conditions (default 1)\n"
+    "  --previous SPEC   run a second-order reversible automaton, each row is the\n"
+    "                    rule applied to the last one xor the one before it; SPEC\n"
+    "                    like --init is the row before the first (random ones use\n"
+    "                    the seed after --seed)\n"
+    "  --reverse         with --previous, step back to the first row after the run\n"
+    "                    and check that the initial rows are recovered\n"
+    "  --quiet           run without printing rows\n"
+    "  --cycles          report the transient length and period of the run\n"
+    "  --stop-on-cycle   like --cycles, and stop as soon as the row repeats\n"
+    "  --stats FORMAT    print density, asymmetry and n-block counts of every\n"
+    "                    generation instead of rows, FORMAT is csv or bin\n"
+    "  --block N         n of the n-block counts and entropy 0-8 (default 3)\n"
+    "  --center-bits N   write N bits of the centre column of an unbounded row\n"
+    "                    to stdout as raw bytes, 0 for an endless stream, the\n"
+    "                    last byte padded with zeros. The row starts from\n"
+    "                    --init with --width (default 1) cells.\n"
+    "  --record FILE     save an animation of the run, one frame per generation\n"
+    "                    showing the latest generations in a square. FILE ends in\n"
+    "                    .gif, .y4m or anything else for PPM images, - is Y4M on\n"
+    "                    stdout, and then --stats, --cycles and --reverse write\n"
+    "                    to stderr. Encoding runs on a separate thread.\n"
+    "  --scale N         pixels per cell in the animation (default 1)\n"
+    "  --fps N           frame rate of the animation (default 30)\n"
+    "  --preimages N     count the rows that step to the initial row and print\n"
+    "                    the first N of them, or report a Garden of Eden\n"
+    "  --basins N[-M]    map every state of rings of N to M cells (at most 30)\n"
+    "                    under the rule and summarize the cycles, their basins\n"
+    "                    and the in-degrees, using 8 bytes per state\n"
+    "  --threads N       step the row in N stripes on worker threads, 0 for one\n"
+    "                    per CPU (default 1, and 0 for --basins). Each worker\n"
+    "                    first touches its own stripe so its pages are local to it.\n"
+    "  --huge-pages      back the row with 2 MB pages where the system has them\n"
+    "  --pin             pin each worker thread to its own CPU\n"
+    "  --bench           measure engine throughput instead, --threads sets the\n"
+    "                    threads of the large row comparison\n"
+    "  --help            show this message\n";
+
+static double seconds(void) {
+    struct timespec ts;
+    timespec_get(&ts, TIME_UTC);
+    return ts.tv_sec + ts.tv_nsec * 1e-9;
+}
+
+// reads a non negative whole number, exponents like 1e9 are allowed
+static int parse_count(const char *arg, uint64_t *out) {
+    char *end;
+    double v = strtod(arg, &end);
+    if (end == arg || *end || v < 0 || v > 1.8e19 || v != (double)(uint64_t)v) return -1;
+    *out = (uint64_t)v;
+    return 0;
+}
+
+static int parse_options(Options *opt, int argc, char **argv) {
+    uint64_t n;
+    int i;
+
+    for (i = 1; i < argc; i++) {
+        const char *arg = argv[i];
+        const char *val = (i + 1 < argc) ? argv[i + 1] : NULL;
+
+        if (strcmp(arg, "--help") == 0) {
+            fputs(usage, stdout);
+            exit(EXIT_SUCCESS);
+        } else if (strcmp(arg, "--quiet") == 0) {
+            opt->quiet = 1;
+            continue;
+        } else if (strcmp(arg, "--bench") == 0) {
+            opt->bench = 1;
+            continue;
+        } else if (strcmp(arg, "--cycles") == 0) {
+            if (!opt->cycles) opt->cycles = 1;
+            continue;
+        } else if (strcmp(arg, "--stop-on-cycle") == 0) {
+            opt->cycles = 2;
+            continue;
+        } else if (strcmp(arg, "--reverse") == 0) {
+            opt->reverse = 1;
+            continue;
+        } else if (strcmp(arg, "--huge-pages") == 0) {
+            opt->placement.huge_pages = 1;
+            continue;
+        } else if (strcmp(arg, "--pin") == 0) {
+            opt->placement.pin = 1;
+            continue;
+        }
+
+        if (!val) {
+            fprintf(stderr, "simulate: unknown or incomplete option '%s'\n", arg);
+            return -1;
+        }
+        i++;
+
+        if (strcmp(arg, "--rule") == 0) {
+            if (parse_count(val, &n) || n > 255) goto bad_value;
+            opt->rule = (int)n;
+        } else if (strcmp(arg, "--width") == 0) {
+            if (parse_count(val, &n) || n == 0) goto bad_value;
+            opt->width = (size_t)n;
+        } else if (strcmp(arg, "--gens") == 0) {
+            if (parse_count(val, &opt->gens)) goto bad_value;
+        } else if (strcmp(arg, "--jump") == 0) {
+            if (parse_count(val, &opt->jump)) goto bad_value;
+        } else if (strcmp(arg, "--boundary") == 0) {
+            int b = boundary_parse(val);
+            if (b < 0) goto bad_value;
+            opt->boundary = b;
+        } else if (strcmp(arg, "--init") == 0) {
+            if (seed_parse(&opt->init, val)) goto bad_value;
+        } else if (strcmp(arg, "--rule-map") == 0) {
+            const char *p = val;
+            do {
+                char *end;
+                long r = strtol(p, &end, 10);
+                if (end == p || r < 0 || r > 255 || (*end && *end != ',')) goto bad_value;
+                p = *end ? end + 1 : end;
+            } while (*p);
+            opt->rule_map = val;
+        } else if (strcmp(arg, "--mix") == 0) {
+            char *end;
+            long r = strtol(val, &end, 10);
+            if (end == val || r < 0 || r > 255 || *end != ':' || seed_parse(&opt->mix, end + 1))
+                goto bad_value;
+            opt->mix_rule = (int)r;
+        } else if (strcmp(arg, "--noise") == 0) {
+            char *end;
+            opt->noise = strtod(val, &end);
+            opt->noise_rule = -1;
+            if (end == val || !(opt->noise >= 0 && opt->noise <= 1)) goto bad_value;
+            if (*end == ':') {
+                const char *r = end + 1;
+                long v = strtol(r, &end, 10);
+                if (end == r || v < 0 || v > 255) goto bad_value;
+                opt->noise_rule = (int)v;
+            }
+            if (*end) goto bad_value;
+        } else if (strcmp(arg, "--previous") == 0) {
+            if (seed_parse(&opt->previous, val)) goto bad_value;
+            opt->second_order = 1;
+        } else if (strcmp(arg, "--seed") == 0) {
+            if (parse_count(val, &opt->init.seed)) goto bad_value;
+        } else if (strcmp(arg, "--stats") == 0) {
+            if      (strcmp(val, "csv") == 0) opt->stats = 1;
+            else if (strcmp(val, "bin") == 0) opt->stats = 2;
+            else goto bad_value;
+        } else if (strcmp(arg, "--center-bits") == 0) {
+            if (parse_count(val, &opt->center_bits)) goto bad_value;
+            opt->center = 1;
+        } else if (strcmp(arg, "--record") == 0) {
+            opt->record = val;
+        } else if (strcmp(arg, "--scale") == 0) {
+            if (parse_count(val, &n) || n < 1 || n > 64) goto bad_value;
+            opt->scale = (int)n;
+        } else if (strcmp(arg, "--fps") == 0) {
+            if (parse_count(val, &n) || n < 1 || n > 100) goto bad_value;
+            opt->fps = (int)n;
+        } else if (strcmp(arg, "--preimages") == 0) {
+            if (parse_count(val, &opt->preimages_max)) goto bad_value;
+            opt->preimages = 1;
+        } else if (strcmp(arg, "--basins") == 0) {
+            char *end;
+            long from = strtol(val, &end, 10), to = from;
+            if (*end == '-') to = strtol(end + 1, &end, 10);
+            if (*end || from < 1 || to < from || to > BASINS_MAX_CELLS) goto bad_value;
+            opt->basins_from = (int)from;
+            opt->basins_to = (int)to;
+        } else if (strcmp(arg, "--threads") == 0) {
+            if (parse_count(val, &n) || n > POOL_MAX_THREADS) goto bad_value;
+            opt->placement.threads = (int)n;
+        } else if (strcmp(arg, "--block") == 0) {
+            if (parse_count(val, &n) || n > STATS_MAX_BLOCK) goto bad_value;
+            opt->block = (int)n;
+        } else {
+            fprintf(stderr, "simulate: unknown option '%s'\n", arg);
+            return -1;
+        }
+        continue;
+
+    bad_value:
+        fprintf(stderr, "simulate: bad value '%s' for %s\n", val, arg);
+        return -1;
+    }
+    return 0;
+}
+
+// prints the cells [from, to) of the row
+static void print_row(const Engine *e, long long from, long long to, char *line) {
+    long long x;
+    for (x = from; x < to; x++)
+        line[x - from] = engine_get(e, x) ? '#' : '.';
+    line[to - from] = '\n';
+    fwrite(line, 1, to - from + 1, stdout);
+}
+
+/*
+ * Function:  film_open
+ * --------------------
+ * starts recording the cells [from, to), the picture is as tall as it is
+ * wide unless the run is shorter
+ *
+ *  returns: 0 on success, -1 if the recorder couldn't be started
+ */
+static int film_open(Film *film, const Options *opt, long long from, long long to) {
+    film->width = (int)(to - from);
+    film->height = opt->gens + 1 < (uint64_t)film->width ? (int)opt->gens + 1 : film->width;
+    film->scale = opt->scale;
+    film->rows = 0;
+
+    long long w = (long long)film->width * film->scale, h = (long long)film->height * film->scale;
+    if (w > 0xffff || h > 0xffff) return -1;
+    film->rec = recorder_open(opt->record, (int)w, (int)h, opt->fps, 16);
+    film->pixels = malloc(w * h * 4);
+    if (!film->rec || !film->pixels) {
+        if (film->rec) recorder_close(film->rec, NULL);
+        free(film->pixels);
+        return -1;
+    }
+    memset(film->pixels, 255, w * h * 4);
+    return 0;
+}
+
+// adds the current generation at the bottom and queues the frame
+static void film_row(Film *film, const Engine *e, long long from) {
+    size_t stride = (size_t)film->width * film->scale * 4;
+    size_t band = stride * film->scale;
+    int x, k;
+
+    if (film->rows == film->height) {
+        memmove(film->pixels, film->pixels + band, band * (film->height - 1));
+        film->rows--;
+    }
+
+    unsigned char *row = film->pixels + band * film->rows++;
+    for (x = 0; x < film->width; x++) {
+        unsigned char v = engine_get(e, from + x) ? 0 : 255;
+        memset(row + (size_t)x * film->scale * 4, v, (size_t)film->scale * 4);
+    }
+    for (k = 1; k < film->scale; k++) memcpy(row + k * stride, row, stride);
+
+    // a batch run would rather wait for the writer than lose frames
+    recorder_push(film->rec, film->pixels, 1);
+}
+
+static void film_close(Film *film, const char *path) {
+    RecordStatus status;
+    if (recorder_close(film->rec, &status) != 0)
+        fprintf(stderr, "simulate: error writing %s\n", path);
+    else
+        fprintf(stderr, "simulate: recorded %llu frames to %s, queue depth up to %d of %d\n",
+                (unsigned long long)status.written, path, status.max_queued, status.slots);
+    free(film->pixels);
+}
+
+// prints what a cycle detector found after the run
+static void report_cycle(FILE *out, const Cycle *c, const Engine *e, const Options *opt) {
+    if (!c->period) {
+        fprintf(out, "cycle: none within %llu generations\n", (unsigned long long)e->generation);
+        return;
+    }
+
+    uint64_t mu = cycle_transient(e, &opt->init, c->period);
+    fprintf(out, "cycle: transient %llu period %llu (found at generation %llu)\n",
+           (unsigned long long)mu, (unsigned long long)c->period,
+           (unsigned long long)e->generation);
+}
+
+/*
+ * Function:  reverse
+ * --------------------
+ * steps a second-order run back to generation 0, printing each row on the
+ * way, and compares both rows with freshly seeded ones
+ *
+ *  out:        stream for the verdict
+ *
+ *  returns: 0 if the initial rows were recovered, else -1
+ */
+static int reverse(FILE *out, Engine *e, const Options *opt, long long from, long long to, char *line) {
+    Engine start;
+    SeedSpec previous = opt->previous;
+    previous.seed = opt->init.seed + 1;
+
+    engine_set_stats(e, NULL);
+    while (e->generation > 0) {
+        engine_step_back(e);
+        if (line) print_row(e, from, to, line);
+    }
+
+    if (engine_init(&start, opt->rule, opt->width, opt->boundary)) return -1;
+    engine_seed(&start, &opt->init);
+    engine_set_previous(&start, &previous);
+
+    size_t words = (size_t)((e->hi - 1) / 64 - e->lo / 64 + 1);
+    int same = engine_equal(e, &start) &&
+               memcmp(e->prev + e->lo / 64, start.prev + start.lo / 64, words * sizeof(uint64_t)) == 0;
+    engine_free(&start);
+
+    fprintf(out, "reverse: %s the initial rows\n", same ? "recovered" : "did not recover");
+    return same ? 0 : -1;
+}
+
+/*
+ * Function:  apply_rule_map
+ * --------------------
+ * sets up the rule of each cell from --rule-map or --mix
+ *
+ *  returns: 0 on success, -1 if out of memory or the mask can't be made
+ */
+static int apply_rule_map(Engine *e, const Options *opt) {
+    int res = -1;
+
+    if (opt->rule_map) {
+        unsigned char *rules = malloc(opt->width), list[256];
+        size_t count = 0, x;
+        const char *p = opt->rule_map;
+        char *end;
+
+        if (!rules) return -1;
+        while (count < 256) {
+            list[count++] = (unsigned char)strtol(p, &end, 10);
+            if (!*end) break;
+            p = end + 1;
+        }
+        for (x = 0; x < opt->width; x++) rules[x] = list[x % count];
+        res = engine_set_rule_map(e, rules);
+        free(rules);
+    } else {
+        uint64_t *select = malloc((opt->width + 63) / 64 * sizeof(uint64_t));
+        SeedSpec mix = opt->mix;
+        mix.seed = opt->init.seed + 2;
+        if (select && seed_fill(&mix, select, opt->width) == 0)
+            res = engine_set_rule_mix(e, opt->rule, opt->mix_rule, select);
+        free(select);
+    }
+    return res;
+}
+
+static int run(const Options *opt) {
+    Engine e;
+    Cycle cycle;
+    Stats stats;
+    uint64_t g;
+
+    if (engine_init_ex(&e, opt->rule, opt->width, opt->boundary, &opt->placement)) {
+        fprintf(stderr, "simulate: can't allocate a row of %zu cells\n", opt->width);
+        return EXIT_FAILURE;
+    }
+    if (engine_seed(&e, &opt->init)) {
+        fprintf(stderr, "simulate: can't generate the initial row with '%s'\n", seed_name(opt->init.kind));
+        engine_free(&e);
+        return EXIT_FAILURE;
+    }
+
+    if ((opt->rule_map || opt->mix_rule >= 0) && apply_rule_map(&e, opt)) {
+        fprintf(stderr, "simulate: can't give the cells their own rules with the %s boundary\n",
+                boundary_name(opt->boundary));
+        engine_free(&e);
+        return EXIT_FAILURE;
+    }
+    if (opt->noise > 0 && engine_set_noise(&e, opt->noise, opt->noise_rule, opt->init.seed + 3)) {
+        fprintf(stderr, "simulate: can't add noise with the %s boundary\n", boundary_name(opt->boundary));
+        engine_free(&e);
+        return EXIT_FAILURE;
+    }
+    if (opt->second_order) {
+        SeedSpec previous = opt->previous;
+        previous.seed = opt->init.seed + 1;
+        if (opt->boundary == BOUNDARY_GROW || engine_set_previous(&e, &previous)) {
+            fprintf(stderr, "simulate: can't generate the previous row with '%s' and the %s boundary\n",
+                    seed_name(previous.kind), boundary_name(opt->boundary));
+            engine_free(&e);
+            return EXIT_FAILURE;
+        }
+    }
+    if (opt->jump) engine_jump(&e, opt->jump);
+
+    // a growing row is printed at its final width so the columns line up
+    long long from = 0, to = (long long)opt->width;
+    if (opt->boundary == BOUNDARY_GROW) {
+        from -= (long long)(opt->jump + opt->gens);
+        to += (long long)(opt->jump + opt->gens);
+    }
+    // with the animation on stdout everything else goes to stderr
+    int piped = opt->record && strcmp(opt->record, "-") == 0;
+    FILE *text = piped ? stderr : stdout;
+    char *line = (opt->quiet || opt->stats || piped) ? NULL : malloc(to - from + 1);
+
+    if (opt->stats) {
+        if (stats_init(&stats, opt->block)) {
+            fprintf(stderr, "simulate: out of memory\n");
+            engine_free(&e);
+            return EXIT_FAILURE;
+        }
+        engine_set_stats(&e, &stats);
+        stats_write_header(text, &stats, opt->stats == 2);
+    }
+
+    Film film = { NULL };
+    if (opt->record && film_open(&film, opt, from, to)) {
+        fprintf(stderr, "simulate: can't record to %s\n", opt->record);
+        if (opt->stats) stats_free(&stats);
+        free(line);
+        engine_free(&e);
+        return EXIT_FAILURE;
+    }
+
+    int cycles = opt->cycles;
+    if (cycles && cycle_init(&cycle, &e)) {
+        if (e.prev)
+            fprintf(stderr, "simulate: cycles can't be detected in second-order rows\n");
+        else if (opt->noise > 0)
+            fprintf(stderr, "simulate: cycles can't be detected in noisy rows\n");
+        else
+            fprintf(stderr, "simulate: cycles can't be detected with the %s boundary\n",
+                    boundary_name(opt->boundary));
+        cycles = 0;
+    }
+
+    for (g = 0; g <= opt->gens; g++) {
+        if (line) print_row(&e, from, to, line);
+        if (opt->stats) stats_write(text, &stats, e.generation, opt->stats == 2);
+        if (film.rec) film_row(&film, &e, from);
+        if (g == opt->gens) break;
+
+        engine_step(&e);
+        if (cycles && cycle_update(&cycle, &e) && cycles == 2) {
+            if (line) print_row(&e, from, to, line);
+            if (opt->stats) stats_write(text, &stats, e.generation, opt->stats == 2);
+            if (film.rec) film_row(&film, &e, from);
+            break;
+        }
+    }
+
+    if (film.rec) film_close(&film, opt->record);
+
+    if (cycles) {
+        if (opt->stats != 2) report_cycle(text, &cycle, &e, opt);
+        cycle_free(&cycle);
+    }
+    if (opt->stats) stats_free(&stats);
+    int status = opt->reverse && reverse(text, &e, opt, from, to, line) ? EXIT_FAILURE : EXIT_SUCCESS;
+    free(line);
+    engine_free(&e);
+    return status;
+}
+
+/*
+ * Function:  run_preimages
+ * --------------------
+ * counts the predecessors of the initial row and prints some of them
+ *
+ *  returns: process exit status
+ */
+static int run_preimages(const Options *opt) {
+    size_t x, words = (opt->width + 63) / 64;
+    uint64_t *row = malloc(words * sizeof(uint64_t)), n, count;
+    char *line = malloc(opt->width + 1);
+    Preimages p;
+    double log2_count;
+
+    if (opt->boundary == BOUNDARY_GROW) {
+        fprintf(stderr, "simulate: preimages can't be found with the grow boundary\n");
+        free(row);
+        free(line);
+        return EXIT_FAILURE;
+    }
+    if (!row || !line || seed_fill(&opt->init, row, opt->width)) {
+        fprintf(stderr, "simulate: can't generate the initial row with '%s'\n", seed_name(opt->init.kind));
+        free(row);
+        free(line);
+        return EXIT_FAILURE;
+    }
+
+    count = preimage_count(opt->rule, opt->boundary, row, opt->width, &log2_count);
+    if (count == 0)               printf("preimages: none, the row is a Garden of Eden\n");
+    else if (count == UINT64_MAX) printf("preimages: about 2^%.2f\n", log2_count);
+    else                          printf("preimages: %llu\n", (unsigned long long)count);
+
+    if (count && opt->preimages_max && !preimages_init(&p, opt->rule, opt->boundary, row, opt->width)) {
+        for (n = 0; n < opt->preimages_max && preimage_next(&p); n++) {
+            for (x = 0; x < opt->width; x++) line[x] = (p.cells[x / 64] >> (x % 64) & 1) ? '#' : '.';
+            line[opt->width] = '\n';
+            fwrite(line, 1, opt->width + 1, stdout);
+        }
+        preimages_free(&p);
+    }
+    free(row);
+    free(line);
+    return EXIT_SUCCESS;
+}
+
+// prints the state transition graph summary of each ring size in turn
+static int run_basins(const Options *opt) {
+    Basins b;
+
+    for (int n = opt->basins_from; n <= opt->basins_to; n++) {
+        if (basins_compute(&b, opt->rule, n, opt->placement.threads)) {
+            fprintf(stderr, "simulate: can't map the states of a ring of %d cells\n", n);
+            return EXIT_FAILURE;
+        }
+        basins_write(stdout, &b);
+        basins_free(&b);
+    }
+    return EXIT_SUCCESS;
+}
+
+static void bench_seed(size_t width, double density) {
+    uint64_t *words = malloc((width + 63) / 64 * sizeof(uint64_t));
+    SeedSpec spec = { SEED_RANDOM, density, 1, NULL };
+    if (!words) return;
+
+    // fault the pages in first so only the generator is timed
+    memset(words, 0, (width + 63) / 64 * sizeof(uint64_t));
+
+    double t = seconds();
+    seed_fill(&spec, words, width);
+    t = seconds() - t;
+
+    printf("seed random:%-16.4g %12zu cells %10.2f ms %10.2f Gcells/s\n",
+           density, width, t * 1e3, width / t * 1e-9);
+    free(words);
+}
+
+// block < 0 steps without statistics, placement NULL on the calling thread
+static void bench_step(int rule, size_t width, uint64_t gens, int block,
+                       const EngineOptions *placement) {
+    Engine e;
+    Stats stats;
+    SeedSpec spec = { SEED_RANDOM, 0.5, 1, NULL };
+    if (engine_init_ex(&e, rule, width, BOUNDARY_PERIODIC, placement)) return;
+    engine_seed(&e, &spec);
+    if (block >= 0 && stats_init(&stats, block) == 0) engine_set_stats(&e, &stats);
+
+    double t = seconds();
+    for (uint64_t g = 0; g < gens; g++) engine_step(&e);
+    t = seconds() - t;
+
+    char name[40];
+    int n = snprintf(name, sizeof(name), block < 0 ? "%d" : "%d stats:%d", rule, block);
+    if (e.pool) n += snprintf(name + n, sizeof(name) - n, " x%d", pool_size(e.pool));
+    if (e.huge) n += snprintf(name + n, sizeof(name) - n, " huge");
+    if (e.pool && placement->pin) snprintf(name + n, sizeof(name) - n, " pin");
+    printf("step rule %-18s %12zu cells %10.2f ms %10.2f Gcells/s\n",
+           name, width, t * 1e3, (double)width * gens / t * 1e-9);
+    if (e.stats) stats_free(&stats);
+    engine_free(&e);
+}
+
+// a random rule for every cell against the uniform bench_step
+static void bench_mapped(size_t width, uint64_t gens) {
+    Engine e;
+    SeedSpec spec = { SEED_RANDOM, 0.5, 1, NULL };
+    unsigned char *rules = malloc(width);
+    Rng rng;
+    if (!rules || engine_init(&e, 30, width, BOUNDARY_PERIODIC)) {
+        free(rules);
+        return;
+    }
+    rng_init(&rng, 1);
+    for (size_t x = 0; x < width; x++) rules[x] = (unsigned char)rng_next(&rng);
+    engine_seed(&e, &spec);
+    engine_set_rule_map(&e, rules);
+
+    double t = seconds();
+    for (uint64_t g = 0; g < gens; g++) engine_step(&e);
+    t = seconds() - t;
+
+    printf("step rule %-18s %12zu cells %10.2f ms %10.2f Gcells/s\n",
+           "map", width, t * 1e3, (double)width * gens / t * 1e-9);
+    free(rules);
+    engine_free(&e);
+}
+
+// rule 30 with a fraction p of the cells flipped, or following rule instead
+static void bench_noise(double p, int rule, size_t width, uint64_t gens) {
+    Engine e;
+    SeedSpec spec = { SEED_RANDOM, 0.5, 1, NULL };
+    char name[64];
+    if (engine_init(&e, 30, width, BOUNDARY_PERIODIC)) return;
+    engine_seed(&e, &spec);
+    engine_set_noise(&e, p, rule, 1);
+
+    double t = seconds();
+    for (uint64_t g = 0; g < gens; g++) engine_step(&e);
+    t = seconds() - t;
+
+    if (rule < 0) snprintf(name, sizeof(name), "30 noise %g", p);
+    else          snprintf(name, sizeof(name), "30 noise %g:%d", p, rule);
+    printf("step rule %-18s %12zu cells %10.2f ms %10.2f Gcells/s\n",
+           name, width, t * 1e3, (double)width * gens / t * 1e-9);
+    engine_free(&e);
+}
+
+// 64 rows of width cells each, stepped as one batch
+static void bench_batch(int rule, size_t width, uint64_t gens) {
+    Batch b;
+    SeedSpec spec = { SEED_RANDOM, 0.5, 1, NULL };
+    if (batch_init(&b, rule, width, BOUNDARY_PERIODIC)) return;
+    batch_seed_all(&b, &spec);
+
+    double t = seconds();
+    for (uint64_t g = 0; g < gens; g++) batch_step(&b);
+    t = seconds() - t;
+
+    char name[32];
+    snprintf(name, sizeof(name), "%d x%d", rule, BATCH_ROWS);
+    printf("batch rule %-17s %12zu cells %10.2f ms %10.2f Gcells/s\n",
+           name, width * BATCH_ROWS, t * 1e3, (double)width * BATCH_ROWS * gens / t * 1e-9);
+    batch_free(&b);
+}
+
+static void bench_jump(int rule, size_t width, uint64_t t) {
+    Engine e;
+    SeedSpec spec = { SEED_RANDOM, 0.5, 1, NULL };
+    if (engine_init(&e, rule, width, BOUNDARY_PERIODIC)) return;
+    engine_seed(&e, &spec);
+
+    double s = seconds();
+    engine_jump(&e, t);
+    s = seconds() - s;
+
+    printf("jump rule %-18d %12zu cells %10.2f ms to generation %llu\n",
+           rule, width, s * 1e3, (unsigned long long)t);
+    engine_free(&e);
+}
+
+static void bench_preimages(int rule, size_t width) {
+    uint64_t *row = malloc((width + 63) / 64 * sizeof(uint64_t));
+    SeedSpec spec = { SEED_RANDOM, 0.5, 1, NULL };
+    double log2_count;
+    if (!row) return;
+    seed_fill(&spec, row, width);
+
+    double t = seconds();
+    int exists = preimage_exists(rule, BOUNDARY_PERIODIC, row, width);
+    double t1 = seconds();
+    preimage_count(rule, BOUNDARY_PERIODIC, row, width, &log2_count);
+    double t2 = seconds();
+
+    printf("preimage rule %-14d %12zu cells %10.2f ms %10.2f Mcells/s exists\n",
+           rule, width, (t1 - t) * 1e3, width / (t1 - t) * 1e-6);
+    printf("preimage rule %-14d %12zu cells %10.2f ms %10.2f Mcells/s count, %s\n",
+           rule, width, (t2 - t1) * 1e3, width / (t2 - t1) * 1e-6,
+           exists ? "has some" : "Garden of Eden");
+    free(row);
+}
+
+static void bench_center(int rule, uint64_t bits) {
+    SeedSpec spec = { SEED_SINGLE, 0, 0, NULL };
+
+    double t = seconds();
+    center_column(rule, &spec, 1, bits, NULL);
+    t = seconds() - t;
+
+    printf("center rule %-16d %12llu bits  %10.2f ms %10.2f Mbits/s\n",
+           rule, (unsigned long long)bits, t * 1e3, bits / t * 1e-6);
+}
+
+/*
+ * Function:  run_bench
+ * --------------------
+ * times random seeding of a large row and the packed and bit-sliced
+ * steppers on small rows, and compares the stepper on a row much larger
+ * than the caches with and without threads, huge pages and pinning
+ *
+ *  width:      cells to seed, the stepper runs on smaller rows
+ *  threads:    workers for the large row, 0 for one per CPU
+ *
+ */
+static int run_bench(size_t width, int threads) {
+    EngineOptions plain = { threads }, huge = { threads, 1, 0 };
+    EngineOptions pinned = { threads, 0, 1 }, both = { threads, 1, 1 };
+
+    bench_seed(width, 0.5);
+    bench_seed(width, 0.3);
+    bench_step(30, 1 << 16, 10000, -1, NULL);
+    bench_step(110, 1 << 16, 10000, -1, NULL);
+    bench_step(90, 1 << 16, 10000, -1, NULL);
+    bench_step(204, 1 << 16, 10000, -1, NULL);
+    bench_mapped(1 << 16, 10000);
+    bench_noise(0.5, -1, 1 << 16, 10000);
+    bench_noise(0.01, -1, 1 << 16, 10000);
+    bench_noise(0.01, 90, 1 << 16, 10000);
+    bench_step(30, 1 << 16, 10000, 0, NULL);
+    bench_step(30, 1 << 16, 10000, 3, NULL);
+    bench_batch(30, 64, 200000);
+    bench_batch(30, 1024, 20000);
+    bench_step(30, 1 << 28, 16, -1, NULL);
+    bench_step(30, 1 << 28, 16, -1, &plain);
+    bench_step(30, 1 << 28, 16, -1, &huge);
+    bench_step(30, 1 << 28, 16, -1, &pinned);
+    bench_step(30, 1 << 28, 16, -1, &both);
+    bench_step(30, 1 << 28, 16, 3, NULL);
+    bench_step(30, 1 << 28, 16, 3, &plain);
+    bench_jump(90, 1 << 20, 1000000000000000000ull);
+    bench_jump(150, 1 << 20, 1000000000000000000ull);
+    bench_preimages(30, 10000000);
+    bench_preimages(110, 10000000);
+    bench_center(30, 1 << 14);
+    bench_center(30, 1 << 16);
+    return EXIT_SUCCESS;
+}
+
+/*
+ * Function:  cli_main
+ * --------------------
+ * runs the automaton headless as described by the command line
+ *
+ *  returns: process exit status
+ */
+int cli_main(int argc, char **argv) {
+    Options opt = {
+        .rule = 30, .gens = 40, .mix_rule = -1, .noise_rule = -1, .boundary = BOUNDARY_PERIODIC, .block = 3, .scale = 1, .fps = 30,
+        .init = { SEED_SINGLE, 0.5, 1, NULL }, .placement = { -1 },
+    };
+
+    if (parse_options(&opt, argc, argv)) {
+        fputs(usage, stderr);
+        return EXIT_FAILURE;
+    }
+
+    // the benchmark and the exhaustive search default to all CPUs, rows to the caller
+    int threads = opt.placement.threads;
+    opt.placement.threads = threads >= 0 ? threads : (opt.bench || opt.basins_from) ? 0 : 1;
+
+    if (opt.bench) return run_bench(opt.width ? opt.width : 1000000000, opt.placement.threads);
+    if (opt.basins_from) return run_basins(&opt);
+    if (opt.preimages) {
+        if (!opt.width) opt.width = 80;
+        return run_preimages(&opt);
+    }
+    if (opt.center) {
+        center_column(opt.rule, &opt.init, opt.width ? opt.width : 1, opt.center_bits, stdout);
+        return EXIT_SUCCESS;
+    }
+    if (!opt.width) opt.width = 80;
+    if (opt.reverse && !opt.second_order) {
+        fprintf(stderr, "simulate: --reverse needs the second-order rows of --previous\n");
+        return EXIT_FAILURE;
+    }
+    return run(&opt);
+}
@@ -0,0 +1,112 @@
+#include <stdlib.h>
+#include <string.h>
+
+#include "cycle.h"
+
+static void mark(Cycle *c, const Engine *e) {
+    memcpy(c->mark_row, e->row + e->lo / 64, c->mark_words * sizeof(uint64_t));
+    c->mark_gen = e->generation;
+    c->mark_hash = e->hash;
+}
+
+/*
+ * Function:  cycle_init
+ * --------------------
+ * starts watching an engine for a repeated row, turning on its hashing.
+ * The detector holds one copy of a row, whatever the length of the run.
+ *
+ *  c:          detector to set up
+ *  e:          engine to watch, not in BOUNDARY_GROW mode, not second
+ *              order, whose state is two rows, and not noisy
+ *
+ *  returns: 0 on success, -1 if the engine's rows can't repeat or if out
+ *           of memory
+ */
+int cycle_init(Cycle *c, Engine *e) {
+    memset(c, 0, sizeof(*c));
+    if (e->boundary == BOUNDARY_GROW || e->prev || e->noise.p > 0) return -1;
+
+    c->mark_words = (size_t)((e->hi - 1) / 64 - e->lo / 64 + 1);
+    c->mark_row = malloc(c->mark_words * sizeof(uint64_t));
+    if (!c->mark_row) return -1;
+
+    engine_set_hashing(e, 1);
+    c->power = 1;
+    mark(c, e);
+    return 0;
+}
+
+void cycle_free(Cycle *c) {
+    free(c->mark_row);
+    c->mark_row = NULL;
+}
+
+/*
+ * Function:  cycle_update
+ * --------------------
+ * checks the engine's current row against the marked one, call it after
+ * every engine_step. The mark moves to the current row whenever the
+ * distance to it reaches the next power of two (Brent's algorithm), so
+ * the first repeat seen is one full period after the mark and c->period
+ * is the smallest period of the cycle.
+ *
+ *  returns: 1 once a cycle has been found, else 0
+ */
+int cycle_update(Cycle *c, const Engine *e) {
+    if (c->period) return 1;
+
+    uint64_t lam = e->generation - c->mark_gen;
+    if (e->hash == c->mark_hash &&
+        memcmp(c->mark_row, e->row + e->lo / 64, c->mark_words * sizeof(uint64_t)) == 0) {
+        c->period = lam;
+        return 1;
+    }
+
+    if (lam == c->power) {
+        mark(c, e);
+        c->power *= 2;
+    }
+    return 0;
+}
+
+/*
+ * Function:  cycle_transient
+ * --------------------
+ * finds the number of generations before the row enters its cycle by
+ * running the seed again twice, one copy period generations ahead
+ *
+ *  e:          engine the cycle was found on, for its rules and boundary
+ *  spec:       initial condition the engine was seeded with
+ *  period:     period of the cycle
+ *
+ *  returns: the transient length, or UINT64_MAX if out of memory
+ */
+uint64_t cycle_transient(const Engine *e, const SeedSpec *spec, uint64_t period) {
+    Engine a, b;
+    uint64_t mu = UINT64_MAX, g;
+
+    if (engine_init(&a, e->rule, e->width, e->boundary)) return mu;
+    if (engine_init(&b, e->rule, e->width, e->boundary)) {
+        engine_free(&a);
+        return mu;
+    }
+    if (engine_copy_rule_map(&a, e) || engine_copy_rule_map(&b, e)) {
+        engine_free(&a);
+        engine_free(&b);
+        return mu;
+    }
+    engine_seed(&a, spec);
+    engine_seed(&b, spec);
+    engine_set_hashing(&a, 1);
+    engine_set_hashing(&b, 1);
+
+    for (g = 0; g < period; g++) engine_step(&b);
+    for (mu = 0; a.hash != b.hash || !engine_equal(&a, &b); mu++) {
+        engine_step(&a);
+        engine_step(&b);
+    }
+
+    engine_free(&a);
+    engine_free(&b);
+    return mu;
+}
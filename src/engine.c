@@ -0,0 +1,989 @@
+#ifdef __linux__
+#define _DEFAULT_SOURCE     /* MAP_ANONYMOUS, MAP_HUGETLB and madvise */
+#include <sys/mman.h>
+#endif
+
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "rules.inl"
+
+// words stepped before the chunk is hashed and collected, 2 KB
+#define CHUNK_WORDS 256
+
+// page sizes in bytes, stripes of a threaded row start on page boundaries
+#define SMALL_PAGE  4096
+#define HUGE_PAGE   (2 << 20)
+
+static const char *boundary_names[BOUNDARY_COUNT] = {
+    [ BOUNDARY_PERIODIC ] = "periodic",
+    [ BOUNDARY_FIXED0   ] = "fixed0",
+    [ BOUNDARY_FIXED1   ] = "fixed1",
+    [ BOUNDARY_REFLECT  ] = "reflect",
+    [ BOUNDARY_GROW     ] = "grow",
+};
+
+const char *boundary_name(Boundary boundary) {
+    return (boundary >= 0 && boundary < BOUNDARY_COUNT) ? boundary_names[boundary] : "?";
+}
+
+/*
+ * Function:  boundary_parse
+ * --------------------
+ *  returns: the boundary called name, or -1 if there is none
+ */
+int boundary_parse(const char *name) {
+    for (int b = 0; b < BOUNDARY_COUNT; b++)
+        if (strcmp(name, boundary_names[b]) == 0) return b;
+    return -1;
+}
+
+static inline int get_bit(const uint64_t *words, long long p) {
+    return (words[p / 64] >> (p % 64)) & 1;
+}
+
+static inline void put_bit(uint64_t *words, long long p, int v) {
+    uint64_t bit = 1ull << (p % 64);
+    words[p / 64] = v ? (words[p / 64] | bit) : (words[p / 64] & ~bit);
+}
+
+/*
+ * Function:  rule_word
+ * --------------------
+ * applies a rule to 64 cells at once, one minterm per set bit of the rule
+ *
+ *  m:          m[k] is all ones if bit k of the rule is set, else zero
+ *  l, c, r:    left neighbors, cells and right neighbors
+ *
+ *  returns: the next state of the 64 cells
+ */
+static inline uint64_t rule_word(const uint64_t m[8], uint64_t l, uint64_t c, uint64_t r) {
+    uint64_t nl = ~l, nc = ~c, nr = ~r;
+    return (m[0] & nl & nc & nr) | (m[1] & nl & nc & r)
+         | (m[2] & nl &  c & nr) | (m[3] & nl &  c & r)
+         | (m[4] &  l & nc & nr) | (m[5] &  l & nc & r)
+         | (m[6] &  l &  c & nr) | (m[7] &  l &  c & r);
+}
+
+/*
+ * Function:  hash_word
+ * --------------------
+ * hash contribution of word i of a row, rows hash to the sum over their
+ * words so the sum can be updated one word at a time while stepping. The
+ * NH construction (one multiply of the two key-offset halves) keeps this
+ * cheap next to the rule evaluation.
+ *
+ */
+static inline uint64_t hash_word(uint64_t w, uint64_t i) {
+    uint64_t k = (i + 1) * 0x9e3779b97f4a7c15ull;
+    return ((uint32_t)w + (k & 0xffffffff)) * ((w >> 32) + (k >> 32));
+}
+
+static uint64_t row_hash(const uint64_t *words, long long first, long long last) {
+    uint64_t h = 0;
+    for (long long i = first; i <= last; i++) h += hash_word(words[i], i - first);
+    return h;
+}
+
+/*
+ * Function:  step_words
+ * --------------------
+ * computes the words [a, b) of the next generation from src with any
+ * rule, the generic path behind the specialized kernels below
+ *
+ */
+static inline void step_words(int rule, const uint64_t *src, uint64_t *dst, long long a, long long b) {
+    uint64_t m[8], prev = src[a - 1], curr = src[a], next;
+    for (int k = 0; k < 8; k++) m[k] = (rule >> k & 1) ? ~0ull : 0;
+    for (long long i = a; i < b; i++) {
+        next = src[i + 1];
+        uint64_t l = (curr << 1) | (prev >> 63);
+        uint64_t r = (curr >> 1) | (next << 63);
+        dst[i] = rule_word(m, l, curr, r);
+        prev = curr;
+        curr = next;
+    }
+}
+
+/*
+ * step_rule_<n> is step_words for rule n alone, with the smallest formula
+ * for the rule from rules.inl in place of the eight minterms, so rule 204
+ * is a copy, rule 90 one xor and rule 0 a fill. Building with
+ * ENGINE_GENERIC steps every rule with step_words instead.
+ */
+#define LEFT  ((curr << 1) | (prev >> 63))
+#define RIGHT ((curr >> 1) | (next << 63))
+
+#ifndef ENGINE_GENERIC
+typedef void (*RuleKernel)(const uint64_t *src, uint64_t *dst, long long a, long long b);
+#define RULE_KERNEL(n)                                                                  \
+    static void step_rule_##n(const uint64_t *src, uint64_t *dst, long long a, long long b) { \
+        uint64_t prev = src[a - 1], curr = src[a], next;                                \
+        for (long long i = a; i < b; i++) {                                             \
+            next = src[i + 1];                                                          \
+            dst[i] = RULE_##n(LEFT, curr, RIGHT);                                       \
+            prev = curr;                                                                \
+            curr = next;                                                                \
+        }                                                                               \
+        (void)prev;                                                                     \
+    }
+#define RULE_KERNEL_ENTRY(n) step_rule_##n,
+
+FOR_EACH_RULE(RULE_KERNEL)
+
+static const RuleKernel rule_kernels[256] = { FOR_EACH_RULE(RULE_KERNEL_ENTRY) };
+#endif
+
+static inline uint64_t mux(uint64_t a, uint64_t b, uint64_t s) {
+    return a ^ ((a ^ b) & s);
+}
+
+/*
+ * Function:  step_mapped
+ * --------------------
+ * step_words for a row with a rule per cell. Bit k of the rules of the
+ * 64 cells of word i is the bit plane map[8 i + k], so looking up bit
+ * 4l + 2c + r of every cell's rule at once is a tree of seven muxes
+ * picking planes by r, then c, then l: 21 operations a word.
+ *
+ */
+static void step_mapped(const uint64_t *map, const uint64_t *src, uint64_t *dst,
+                        long long a, long long b) {
+    uint64_t prev = src[a - 1], curr = src[a], next;
+    for (long long i = a; i < b; i++) {
+        const uint64_t *p = map + 8 * i;
+        next = src[i + 1];
+        uint64_t l = LEFT, r = RIGHT;
+        uint64_t lo = mux(mux(p[0], p[1], r), mux(p[2], p[3], r), curr);
+        uint64_t hi = mux(mux(p[4], p[5], r), mux(p[6], p[7], r), curr);
+        dst[i] = mux(lo, hi, l);
+        prev = curr;
+        curr = next;
+    }
+}
+
+/*
+ * Function:  add_noise
+ * --------------------
+ * lets the cells of the words [a, b) of dst, just stepped from src,
+ * deviate from their rule. The mask of deviating cells is drawn for the
+ * word positions and the generation, so a row comes out the same
+ * whatever stripes and chunks it's stepped in.
+ *
+ */
+static void add_noise(const Noise *noise, uint64_t generation, const uint64_t *src,
+                      uint64_t *dst, long long a, long long b) {
+    uint64_t mask[CHUNK_WORDS], alt[CHUNK_WORDS + 1];
+    long long i, n = b - a;
+
+    rng_bernoulli_at(noise->seed, generation, (uint64_t)a, mask, (size_t)n, noise->p);
+    if (noise->rule < 0) {
+        for (i = 0; i < n; i++) dst[a + i] ^= mask[i];
+        return;
+    }
+
+    // the other rule's words into alt[1 .. n], reading src[a - 1 .. b]
+#ifdef ENGINE_GENERIC
+    step_words(noise->rule, src + a - 1, alt, 1, n + 1);
+#else
+    rule_kernels[noise->rule](src + a - 1, alt, 1, n + 1);
+#endif
+    for (i = 0; i < n; i++) dst[a + i] = mux(dst[a + i], alt[i + 1], mask[i]);
+}
+
+/*
+ * Function:  step_range
+ * --------------------
+ * computes the words [from, to) of the next generation of the cells
+ * [lo, hi), from and to are clipped to the words holding them. The cells
+ * lo - 1 and hi of src must hold the boundary, and every bit of dst
+ * outside [lo, hi) in the words that are written is cleared. With map
+ * each cell follows its own rule instead of rule, with noise some of
+ * them don't, and with prev the row before src is xored in, for
+ * second-order rows. stats must have been started on the row, or on the
+ * stripe from from on (see stats_part).
+ *
+ * The row is stepped in chunks small enough to stay in L1, and each chunk
+ * is hashed and handed to the statistics collector right after it's
+ * written, so neither costs another pass through memory. hashing is a
+ * constant at each call, so the hash costs nothing when it's not wanted.
+ *
+ *  returns: row_hash of the cells written to dst, or 0 without hashing
+ */
+static inline uint64_t step_range(int rule, const uint64_t *map, const Noise *noise,
+                                  uint64_t generation, const uint64_t *src, uint64_t *dst,
+                                  const uint64_t *prev, long long lo, long long hi,
+                                  long long from, long long to, const int hashing, Stats *stats) {
+    long long a, b, i, first = lo / 64, last = (hi - 1) / 64;
+    uint64_t h = 0;
+
+    if (from < first)  from = first;
+    if (to > last + 1) to = last + 1;
+    for (a = from; a < to; a = b) {
+        b = (to - a > CHUNK_WORDS) ? a + CHUNK_WORDS : to;
+        if (map)
+            step_mapped(map, src, dst, a, b);
+        else
+#ifdef ENGINE_GENERIC
+            step_words(rule, src, dst, a, b);
+#else
+            rule_kernels[rule](src, dst, a, b);
+#endif
+        if (noise) add_noise(noise, generation, src, dst, a, b);
+        if (prev) for (i = a; i < b; i++) dst[i] ^= prev[i];
+
+        if (a == first) dst[first] &= ~0ull << (lo % 64);
+        if (b > last)   dst[last]  &= ~0ull >> (63 - (hi - 1) % 64);
+
+        if (hashing) for (i = a; i < b; i++) h += hash_word(dst[i], i - first);
+        if (stats) stats_words(stats, dst, a, b);
+    }
+    return h;
+}
+
+#ifdef __linux__
+static size_t mapped_size(size_t words) {
+    return (words * sizeof(uint64_t) + HUGE_PAGE - 1) / HUGE_PAGE * HUGE_PAGE;
+}
+#endif
+
+/*
+ * Function:  row_alloc
+ * --------------------
+ * allocates a zeroed buffer. With huge set it's mapped directly and
+ * aligned to 2 MB, from the reserved huge pages if there are any and
+ * otherwise with a request for transparent ones, so that a big row costs
+ * one TLB entry per 2 MB instead of per 4 KB. Its pages aren't touched,
+ * so they are placed on the NUMA node of the first thread to write them.
+ *
+ *  returns: the buffer, or NULL if out of memory
+ */
+static uint64_t *row_alloc(size_t words, int huge) {
+#ifdef __linux__
+    if (huge) {
+        size_t size = mapped_size(words);
+        int prot = PROT_READ | PROT_WRITE, flags = MAP_PRIVATE | MAP_ANONYMOUS;
+
+        void *p = mmap(NULL, size, prot, flags | MAP_HUGETLB, -1, 0);
+        if (p != MAP_FAILED) return p;
+
+        // map a huge page more than needed and trim it to an aligned range
+        char *q = mmap(NULL, size + HUGE_PAGE, prot, flags, -1, 0);
+        if (q == MAP_FAILED) return NULL;
+        size_t head = (HUGE_PAGE - (uintptr_t)q % HUGE_PAGE) % HUGE_PAGE;
+        if (head) munmap(q, head);
+        munmap(q + head + size, HUGE_PAGE - head);
+        madvise(q + head, size, MADV_HUGEPAGE);
+        return (uint64_t *)(q + head);
+    }
+#endif
+    return calloc(words, sizeof(uint64_t));
+}
+
+static void row_free(uint64_t *row, size_t words, int huge) {
+    if (!row) return;
+#ifdef __linux__
+    if (huge) {
+        munmap(row, mapped_size(words));
+        return;
+    }
+#endif
+    free(row);
+}
+
+/*
+ * Function:  stripe
+ * --------------------
+ * finds the words [*a, *b) of the buffers that belong to worker k of n.
+ * Stripes are cut at page boundaries so every page is written first,
+ * and from then on only, by the worker stepping it.
+ *
+ */
+static void stripe(const Engine *e, int k, int n, long long *a, long long *b) {
+    long long page = (e->huge ? HUGE_PAGE : SMALL_PAGE) / sizeof(uint64_t);
+    *a = k == 0     ? 0                     : (long long)(e->words * k / n) / page * page;
+    *b = k == n - 1 ? (long long)e->words : (long long)(e->words * (k + 1) / n) / page * page;
+}
+
+// places the pages of a worker's stripe on its NUMA node by zeroing them
+static void touch_stripe(void *arg, int k, int n) {
+    Engine *e = arg;
+    long long a, b;
+
+    stripe(e, k, n, &a, &b);
+    if (a >= b) return;
+    memset(e->row + a, 0, (b - a) * sizeof(uint64_t));
+    memset(e->next + a, 0, (b - a) * sizeof(uint64_t));
+}
+
+// places the pages of a worker's stripe of the previous row, see touch_stripe
+static void touch_prev(void *arg, int k, int n) {
+    Engine *e = arg;
+    long long a, b;
+
+    stripe(e, k, n, &a, &b);
+    if (a < b) memset(e->prev + a, 0, (b - a) * sizeof(uint64_t));
+}
+
+// and of the rule map
+static void touch_map(void *arg, int k, int n) {
+    Engine *e = arg;
+    long long a, b;
+
+    stripe(e, k, n, &a, &b);
+    if (a < b) memset(e->map + 8 * a, 0, 8 * (b - a) * sizeof(uint64_t));
+}
+
+typedef struct {
+    Engine     *e;
+    Noise      *noise;                      /* &e->noise if there is any, else NULL */
+    uint64_t    hash[POOL_MAX_THREADS];     /* row_hash of each stripe */
+    int         used[POOL_MAX_THREADS];     /* the stripe holds some of the row */
+} StripeStep;
+
+static void step_stripe(void *arg, int k, int n) {
+    StripeStep *s = arg;
+    Engine *e = s->e;
+    Stats *part = NULL;
+    long long a, b;
+
+    stripe(e, k, n, &a, &b);
+    if (a < e->lo / 64)           a = e->lo / 64;
+    if (b > (e->hi - 1) / 64 + 1) b = (e->hi - 1) / 64 + 1;
+    s->used[k] = a < b;
+    if (!s->used[k]) return;
+
+    if (e->stats) {
+        part = &e->parts[k];
+        stats_part(part, e->stats, a);
+    }
+    if (e->hashing) s->hash[k] = step_range(e->rule, e->map, s->noise, e->generation, e->row, e->next,
+                                            e->prev, e->lo, e->hi, a, b, 1, part);
+    else            s->hash[k] = step_range(e->rule, e->map, s->noise, e->generation, e->row, e->next,
+                                            e->prev, e->lo, e->hi, a, b, 0, part);
+}
+
+/*
+ * Function:  recenter
+ * --------------------
+ * moves a growing row to the middle of buffers of at least twice the
+ * size once it gets near either end, so growth costs amortized O(1)
+ * reallocations per word
+ *
+ *  returns: 0 on success, -1 if out of memory
+ */
+static int recenter(Engine *e) {
+    long long margin = 2 * 64;
+    if (e->lo >= margin && e->hi + margin <= (long long)e->words * 64) return 0;
+
+    size_t span = (size_t)((e->hi - 1) / 64 - e->lo / 64 + 1);
+    size_t words = e->words * 2;
+    while (words < span + 8) words *= 2;
+
+    uint64_t *row = row_alloc(words, e->huge);
+    uint64_t *next = row_alloc(words, e->huge);
+    if (!row || !next) {
+        row_free(row, words, e->huge);
+        row_free(next, words, e->huge);
+        return -1;
+    }
+
+    long long shift = (long long)((words - span) / 2) - e->lo / 64;
+    memcpy(row + e->lo / 64 + shift, e->row + e->lo / 64, span * sizeof(uint64_t));
+    row_free(e->row, e->words, e->huge);
+    row_free(e->next, e->words, e->huge);
+    e->row = row;
+    e->next = next;
+    e->words = words;
+    e->lo += shift * 64;
+    e->hi += shift * 64;
+    e->origin += shift * 64;
+    return 0;
+}
+
+/*
+ * Function:  engine_init
+ * --------------------
+ * creates an empty row
+ *
+ *  e:          engine to set up
+ *  rule:       elementary rule 0-255
+ *  width:      number of cells, or the initial number of stored cells for
+ *              BOUNDARY_GROW
+ *  boundary:   boundary condition
+ *
+ *  returns: 0 on success, -1 on bad arguments or if out of memory
+ */
+int engine_init(Engine *e, int rule, size_t width, Boundary boundary) {
+    return engine_init_ex(e, rule, width, boundary, NULL);
+}
+
+/*
+ * Function:  engine_init_ex
+ * --------------------
+ * like engine_init, with control over where a large row lives. With
+ * more than one thread the row is cut into one stripe per worker, and
+ * each worker zeroes its stripe before anything else writes it, so on a
+ * NUMA machine its pages end up on the worker's node; pinning keeps the
+ * worker there. Rows that grow are stepped by the caller alone.
+ *
+ *  opt:        placement, NULL for the defaults of engine_init
+ *
+ *  returns: 0 on success, -1 on bad arguments or if out of memory
+ */
+int engine_init_ex(Engine *e, int rule, size_t width, Boundary boundary,
+                   const EngineOptions *opt) {
+    memset(e, 0, sizeof(*e));
+    if (width == 0 || rule < 0 || rule > 255) return -1;
+
+    e->rule = rule;
+    e->boundary = boundary;
+    e->width = width;
+
+    // one word of margin on each side holds the boundary cells
+    e->words = (width + 1 + 63) / 64 + 2;
+    if (boundary == BOUNDARY_GROW) e->words = 2 * e->words + 8;
+
+    e->huge = opt && opt->huge_pages;
+    e->row = row_alloc(e->words, e->huge);
+    e->next = row_alloc(e->words, e->huge);
+    if (!e->row || !e->next) {
+        engine_free(e);
+        return -1;
+    }
+
+    if (opt && opt->threads != 1 && boundary != BOUNDARY_GROW) {
+        e->pool = pool_start(opt->threads, opt->pin);
+        if (e->pool) pool_run(e->pool, touch_stripe, e);
+    }
+
+    SeedSpec empty = { SEED_STRING, 0, 0, "0" };
+    engine_seed(e, &empty);
+    return 0;
+}
+
+void engine_free(Engine *e) {
+    pool_free(e->pool);
+    row_free(e->row, e->words, e->huge);
+    row_free(e->next, e->words, e->huge);
+    row_free(e->prev, e->words, e->huge);
+    row_free(e->map, 8 * e->words, e->huge);
+    free(e->parts);
+    e->parts = NULL;
+    e->pool = NULL;
+    e->row = e->next = e->prev = e->map = NULL;
+}
+
+/*
+ * Function:  engine_seed
+ * --------------------
+ * replaces the row with a freshly generated one of the initial width
+ *
+ *  returns: result of seed_fill
+ */
+int engine_seed(Engine *e, const SeedSpec *spec) {
+    if (e->boundary == BOUNDARY_GROW) {
+        memset(e->row, 0, e->words * sizeof(uint64_t));
+        e->lo = (long long)(e->words - (e->width + 63) / 64) / 2 * 64;
+    } else {
+        e->lo = 64;
+        e->row[0] = 0;
+        e->row[e->words - 1] = 0;
+    }
+    e->hi = e->lo + e->width;
+    e->origin = e->lo;
+    e->background = 0;
+    e->generation = 0;
+
+    int res = seed_fill(spec, e->row + e->lo / 64, e->width);
+    engine_set_hashing(e, e->hashing);
+    engine_set_stats(e, e->stats);
+    return res;
+}
+
+/*
+ * Function:  engine_set_previous
+ * --------------------
+ * makes the row second order: each generation becomes the rule applied
+ * to the current one xored with the one before it, which is reversible
+ * whatever the rule, see engine_step_back. The row before the current
+ * one is generated from spec like engine_seed does, and engine_seed
+ * leaves it alone.
+ *
+ *  spec:       row before the current one, NULL for all dead cells
+ *
+ *  returns: result of seed_fill, or -1 with BOUNDARY_GROW or if out of
+ *           memory
+ */
+int engine_set_previous(Engine *e, const SeedSpec *spec) {
+    if (e->boundary == BOUNDARY_GROW) return -1;
+    if (!e->prev) {
+        e->prev = row_alloc(e->words, e->huge);
+        if (!e->prev) return -1;
+        if (e->pool) pool_run(e->pool, touch_prev, e);
+    }
+
+    memset(e->prev, 0, e->words * sizeof(uint64_t));
+    return spec ? seed_fill(spec, e->prev + e->lo / 64, e->width) : 0;
+}
+
+// allocates the rule map, or clears the one there is
+static int alloc_map(Engine *e) {
+    if (e->boundary == BOUNDARY_GROW) return -1;
+    if (!e->map) {
+        e->map = row_alloc(8 * e->words, e->huge);
+        if (!e->map) return -1;
+        if (e->pool) pool_run(e->pool, touch_map, e);
+    }
+    memset(e->map, 0, 8 * e->words * sizeof(uint64_t));
+    return 0;
+}
+
+/*
+ * Function:  engine_set_rule_map
+ * --------------------
+ * gives each cell a rule of its own, for a hybrid automaton, or goes
+ * back to e->rule for all of them. The rules are stored as bit planes
+ * next to the row, 64 bytes for every 64 cells.
+ *
+ *  rules:      width rules 0-255, rules[x] for cell x, or NULL for e->rule
+ *
+ *  returns: 0 on success, -1 with BOUNDARY_GROW or if out of memory
+ */
+int engine_set_rule_map(Engine *e, const unsigned char *rules) {
+    if (!rules) {
+        row_free(e->map, 8 * e->words, e->huge);
+        e->map = NULL;
+        return 0;
+    }
+    if (alloc_map(e)) return -1;
+
+    for (size_t x = 0; x < e->width; x++) {
+        long long p = e->lo + (long long)x;
+        for (int k = 0; k < 8; k++)
+            e->map[8 * (p / 64) + k] |= (uint64_t)(rules[x] >> k & 1) << (p % 64);
+    }
+    return 0;
+}
+
+/*
+ * Function:  engine_copy_rule_map
+ * --------------------
+ * gives each cell of e the rule of the same cell of from, or e->rule if
+ * from has no rule map
+ *
+ *  from:       engine of the same width and boundary as e
+ *
+ *  returns: 0 on success, -1 if the engines don't match or if out of
+ *           memory
+ */
+int engine_copy_rule_map(Engine *e, const Engine *from) {
+    if (!from->map) return engine_set_rule_map(e, NULL);
+    if (e->words != from->words || alloc_map(e)) return -1;
+    memcpy(e->map, from->map, 8 * e->words * sizeof(uint64_t));
+    return 0;
+}
+
+/*
+ * Function:  engine_set_rule_mix
+ * --------------------
+ * gives each cell one of two rules, picked by a mask packed like the row
+ *
+ *  a, b:       rules of the cells whose bit in select is clear, and set
+ *  select:     width bits, bit x % 64 of select[x / 64] is for cell x
+ *
+ *  returns: 0 on success, -1 on bad rules, with BOUNDARY_GROW or if out
+ *           of memory
+ */
+int engine_set_rule_mix(Engine *e, int a, int b, const uint64_t *select) {
+    size_t words = (e->width + 63) / 64, i;
+
+    if (a < 0 || a > 255 || b < 0 || b > 255 || alloc_map(e)) return -1;
+    for (i = 0; i < words; i++) {
+        uint64_t s = select[i], *p = e->map + 8 * (e->lo / 64 + i);
+        for (int k = 0; k < 8; k++)
+            p[k] = ((a >> k & 1) ? ~s : 0) | ((b >> k & 1) ? s : 0);
+    }
+    return 0;
+}
+
+/*
+ * Function:  engine_set_noise
+ * --------------------
+ * makes the row stochastic: in every generation each cell independently
+ * follows rule instead of its own with probability p, or is flipped. The
+ * random bits are drawn in bulk, a handful of 64 bit hashes for every
+ * word of cells (see rng_bernoulli_at), and depend only on seed, the
+ * generation and the cell, so a run can be repeated with any number of
+ * threads.
+ *
+ *  p:          probability of a cell deviating, 0 to turn noise off;
+ *              it's rounded to multiples of 2^-16
+ *  rule:       rule 0-255 of the deviating cells, or -1 to flip them
+ *  seed:       seed of the noise
+ *
+ *  returns: 0 on success, -1 on a bad rule or p, or with BOUNDARY_GROW
+ */
+int engine_set_noise(Engine *e, double p, int rule, uint64_t seed) {
+    if (!(p >= 0 && p <= 1) || rule < -1 || rule > 255) return -1;
+    if (p > 0 && e->boundary == BOUNDARY_GROW) return -1;
+    e->noise.p = p;
+    e->noise.rule = rule;
+    e->noise.seed = seed;
+    return 0;
+}
+
+/*
+ * Function:  engine_step_back
+ * --------------------
+ * undoes one engine_step of a second-order row: the row before the
+ * previous one is the rule applied to the previous one xored with the
+ * current one, the same step with the two rows swapped. The noise of
+ * that step is drawn again, so noisy rows step back exactly too. Does
+ * nothing to first-order rows.
+ *
+ */
+void engine_step_back(Engine *e) {
+    uint64_t *tmp;
+    Stats *stats = e->stats;
+
+    if (!e->prev) return;
+    tmp = e->row;
+    e->row = e->prev;
+    e->prev = tmp;
+    e->stats = NULL;
+    e->generation--;
+    engine_step(e);
+
+    tmp = e->row;
+    e->row = e->prev;
+    e->prev = tmp;
+    e->generation--;
+    engine_set_hashing(e, e->hashing);
+    engine_set_stats(e, stats);
+}
+
+/*
+ * Function:  engine_set_stats
+ * --------------------
+ * attaches a statistics collector that engine_step fills in for every new
+ * generation, or detaches it with NULL. The current row is collected
+ * right away. With worker threads each worker collects its own stripe
+ * and the stripes are merged after each step; if there's no memory for
+ * that the row is stepped by the caller alone while stats are attached.
+ *
+ */
+void engine_set_stats(Engine *e, Stats *stats) {
+    e->stats = stats;
+    if (!stats) return;
+    if (e->pool && !e->parts) e->parts = malloc(pool_size(e->pool) * sizeof(Stats));
+
+    long long first = e->lo / 64, last = (e->hi - 1) / 64;
+    stats_begin(stats, e->lo, e->hi);
+    stats_words(stats, e->row, first, last + 1);
+    stats_end(stats, e->row);
+}
+
+/*
+ * Function:  engine_set_hashing
+ * --------------------
+ * turns upkeep of e->hash on or off, it's off after engine_init
+ *
+ */
+void engine_set_hashing(Engine *e, int on) {
+    e->hashing = on;
+    e->hash = on ? row_hash(e->row, e->lo / 64, (e->hi - 1) / 64) : 0;
+}
+
+/*
+ * Function:  engine_step
+ * --------------------
+ * advances the row by one generation
+ *
+ */
+void engine_step(Engine *e) {
+    int left, right;
+    long long lo = e->lo, hi = e->hi;
+    uint64_t *tmp;
+
+    if (e->boundary == BOUNDARY_GROW) {
+        // if the row can't grow it keeps its width with background edges
+        if (recenter(e) == 0) {
+            lo = e->lo - 1;
+            hi = e->hi + 1;
+            put_bit(e->row, e->lo - 2, e->background);
+            put_bit(e->row, e->hi + 1, e->background);
+        }
+        left = right = e->background;
+    } else {
+        switch (e->boundary) {
+            case BOUNDARY_FIXED0:  left = 0;                         right = 0;                         break;
+            case BOUNDARY_FIXED1:  left = 1;                         right = 1;                         break;
+            case BOUNDARY_REFLECT: left = get_bit(e->row, e->lo);     right = get_bit(e->row, e->hi - 1); break;
+            default:               left = get_bit(e->row, e->hi - 1); right = get_bit(e->row, e->lo);     break;
+        }
+    }
+    put_bit(e->row, e->lo - 1, left);
+    put_bit(e->row, e->hi, right);
+
+    Noise *noise = e->noise.p > 0 ? &e->noise : NULL;
+    if (e->stats) stats_begin(e->stats, lo, hi);
+    if (e->pool && (!e->stats || e->parts)) {
+        StripeStep s = { e, noise };
+        pool_run(e->pool, step_stripe, &s);
+        e->hash = 0;
+        for (int k = 0; k < pool_size(e->pool); k++) {
+            if (!s.used[k]) continue;
+            if (e->hashing) e->hash += s.hash[k];
+            if (e->stats)   stats_merge(e->stats, &e->parts[k], e->next);
+        }
+    } else if (e->hashing) {
+        e->hash = step_range(e->rule, e->map, noise, e->generation, e->row, e->next, e->prev,
+                             lo, hi, lo / 64, (hi - 1) / 64 + 1, 1, e->stats);
+    } else {
+        step_range(e->rule, e->map, noise, e->generation, e->row, e->next, e->prev,
+                   lo, hi, lo / 64, (hi - 1) / 64 + 1, 0, e->stats);
+    }
+    if (e->stats) stats_end(e->stats, e->next);
+
+    // a second-order row keeps the current generation, less its boundary, as the previous one
+    tmp = e->prev ? e->prev : e->row;
+    if (e->prev) {
+        e->prev = e->row;
+        put_bit(e->prev, e->lo - 1, 0);
+        put_bit(e->prev, e->hi, 0);
+    }
+    e->row = e->next;
+    e->next = tmp;
+    e->lo = lo;
+    e->hi = hi;
+    if (e->boundary == BOUNDARY_GROW)
+        e->background = (e->rule >> (e->background ? 7 : 0)) & 1;
+    e->generation++;
+}
+
+/*
+ * Function:  rule_affine
+ * --------------------
+ * checks whether a rule is affine over GF(2), f(l, c, r) = a l ^ b c ^ c' r ^ k.
+ * These are 60, 90, 102, 150 and the trivial rules, and their complements.
+ *
+ *  coef:       receives a, b, c' and k
+ *
+ *  returns: 1 if the rule is affine, else 0
+ */
+static int rule_affine(int rule, int coef[4]) {
+    int k = rule & 1;
+    coef[0] = (rule >> 4 & 1) ^ k;
+    coef[1] = (rule >> 2 & 1) ^ k;
+    coef[2] = (rule >> 1 & 1) ^ k;
+    coef[3] = k;
+    for (int x = 0; x < 8; x++)
+        if ((rule >> x & 1) != ((coef[0] & x >> 2) ^ (coef[1] & x >> 1) ^ (coef[2] & x) ^ k))
+            return 0;
+    return 1;
+}
+
+// dst ^= src moved up by k bits, bits moved past the end are left for the caller to clear
+static void xor_up(uint64_t *dst, const uint64_t *src, size_t words, size_t k) {
+    size_t q = k / 64, r = k % 64;
+    for (size_t i = words; i-- > q;) {
+        uint64_t w = src[i - q] << r;
+        if (r && i > q) w |= src[i - q - 1] >> (64 - r);
+        dst[i] ^= w;
+    }
+}
+
+// dst ^= src moved down by k bits
+static void xor_down(uint64_t *dst, const uint64_t *src, size_t words, size_t k) {
+    size_t q = k / 64, r = k % 64;
+    for (size_t i = 0; i + q < words; i++) {
+        uint64_t w = src[i + q] >> r;
+        if (r && i + q + 1 < words) w |= src[i + q + 1] << (64 - r);
+        dst[i] ^= w;
+    }
+}
+
+/*
+ * Function:  ring_jump
+ * --------------------
+ * advances a ring of n cells by t generations of an affine rule. Over
+ * GF(2) squaring the rule's operator a S + b + c' S^-1, with S the
+ * rotation by one cell, gives a S^2 + b + c' S^-2, so its 2^j-th power
+ * is three rotations by 2^j and the whole jump is one such step for each
+ * set bit of t: O(n log t) work instead of O(n t). The constant k adds
+ * the all ones row, which the operator maps to (a ^ b ^ c') times
+ * itself, so it adds up to t % 2 ones rows if that is 1 and to one
+ * otherwise.
+ *
+ *  x, tmp:     rings of n cells in the low bits, bits past n clear; the
+ *              result ends up in *x, the pointers may be swapped
+ *
+ */
+static void ring_jump(uint64_t **x, uint64_t **tmp, size_t n, const int coef[4], uint64_t t) {
+    size_t words = (n + 63) / 64;
+    uint64_t last = n % 64 ? ~0ull >> (64 - n % 64) : ~0ull;
+    uint64_t shift = 1 % n;     /* 2^j mod n */
+
+    for (uint64_t bits = t; bits; bits >>= 1) {
+        if (bits & 1) {
+            uint64_t *src = *x, *dst = *tmp;
+            if (coef[1]) memcpy(dst, src, words * sizeof(uint64_t));
+            else         memset(dst, 0, words * sizeof(uint64_t));
+            if (coef[0] && shift) {
+                xor_up(dst, src, words, shift);
+                xor_down(dst, src, words, n - shift);
+            } else if (coef[0]) {
+                for (size_t i = 0; i < words; i++) dst[i] ^= src[i];
+            }
+            if (coef[2] && shift) {
+                xor_down(dst, src, words, shift);
+                xor_up(dst, src, words, n - shift);
+            } else if (coef[2]) {
+                for (size_t i = 0; i < words; i++) dst[i] ^= src[i];
+            }
+            dst[words - 1] &= last;
+            *x = dst;
+            *tmp = src;
+        }
+        shift = (shift * 2) % n;
+    }
+
+    if (coef[3] && ((coef[0] ^ coef[1] ^ coef[2]) ? t % 2 : t > 0)) {
+        for (size_t i = 0; i < words; i++) (*x)[i] = ~(*x)[i];
+        (*x)[words - 1] &= last;
+    }
+}
+
+/*
+ * Function:  mirror_jump
+ * --------------------
+ * jumps a row with a fixed0 or reflect boundary under a symmetric affine
+ * rule, by running the row and its mirror image as one ring: a reflect
+ * boundary is the ring x reversed(x) of 2n cells, fixed0 the ring
+ * x 0 reversed(x) 0 of 2n + 2 cells. A symmetric rule keeps the ring
+ * symmetric, so the boundary cells stay what they are.
+ *
+ *  returns: 0 on success, -1 if out of memory
+ */
+static int mirror_jump(Engine *e, const int coef[4], uint64_t t) {
+    size_t n = e->width, ring = e->boundary == BOUNDARY_REFLECT ? 2 * n : 2 * n + 2;
+    size_t words = (ring + 63) / 64, i;
+    uint64_t *x = calloc(words, sizeof(uint64_t)), *tmp = calloc(words, sizeof(uint64_t));
+    const uint64_t *row = e->row + e->lo / 64;
+
+    if (!x || !tmp) {
+        free(x);
+        free(tmp);
+        return -1;
+    }
+    memcpy(x, row, (n + 63) / 64 * sizeof(uint64_t));
+    for (i = 0; i < n; i++)
+        if (get_bit(row, i)) put_bit(x, ring - 1 - i - (ring - 2 * n) / 2, 1);
+
+    ring_jump(&x, &tmp, ring, coef, t);
+
+    memcpy(e->row + e->lo / 64, x, (n + 63) / 64 * sizeof(uint64_t));
+    if (n % 64) e->row[e->lo / 64 + (n - 1) / 64] &= ~0ull >> (64 - n % 64);
+    free(x);
+    free(tmp);
+    return 0;
+}
+
+/*
+ * Function:  engine_jump
+ * --------------------
+ * advances the row by t generations at once. Rows of affine rules (60,
+ * 90, 102, 150, their complements and the trivial rules) take
+ * O(width log t): periodic rows with any of them, reflect rows with the
+ * symmetric ones and fixed0 rows with the symmetric linear ones. Other
+ * rows, second-order, hybrid and noisy ones included, are stepped t times.
+ *
+ */
+void engine_jump(Engine *e, uint64_t t) {
+    int coef[4], fast = 0;
+
+    if (t && !e->prev && !e->map && !(e->noise.p > 0) && rule_affine(e->rule, coef)) {
+        int symmetric = coef[0] == coef[2];
+        if (e->boundary == BOUNDARY_PERIODIC) {
+            uint64_t *x = e->row + e->lo / 64, *tmp = e->next + e->lo / 64;
+            ring_jump(&x, &tmp, e->width, coef, t);
+            if (x != e->row + e->lo / 64) {
+                tmp = e->row;
+                e->row = e->next;
+                e->next = tmp;
+            }
+            fast = 1;
+        } else if ((e->boundary == BOUNDARY_REFLECT && symmetric) ||
+                   (e->boundary == BOUNDARY_FIXED0 && symmetric && !coef[3])) {
+            fast = mirror_jump(e, coef, t) == 0;
+        }
+    }
+
+    if (!fast) {
+        for (; t; t--) engine_step(e);
+        return;
+    }
+    e->generation += t;
+    engine_set_hashing(e, e->hashing);
+    engine_set_stats(e, e->stats);
+}
+
+static void clear_bits(uint64_t *words, long long a, long long b) {
+    for (; a < b && a % 64; a++) put_bit(words, a, 0);
+    for (; a + 64 <= b; a += 64) words[a / 64] = 0;
+    for (; a < b; a++) put_bit(words, a, 0);
+}
+
+/*
+ * Function:  engine_crop
+ * --------------------
+ * narrows the stored cells to [from, to), the cells dropped become
+ * background. Used to skip cells that can't influence the cells of
+ * interest in later generations.
+ *
+ *  from, to:   cell indices, 0 is the first cell of the seeded row
+ *
+ */
+void engine_crop(Engine *e, long long from, long long to) {
+    long long lo = e->origin + from, hi = e->origin + to;
+    if (lo < e->lo) lo = e->lo;
+    if (hi > e->hi) hi = e->hi;
+    if (hi <= lo) hi = lo + 1;
+
+    clear_bits(e->row, e->lo, lo);
+    clear_bits(e->row, hi, e->hi);
+    if (e->prev) {
+        clear_bits(e->prev, e->lo, lo);
+        clear_bits(e->prev, hi, e->hi);
+    }
+    e->lo = lo;
+    e->hi = hi;
+    engine_set_hashing(e, e->hashing);
+    engine_set_stats(e, e->stats);
+}
+
+/*
+ * Function:  engine_equal
+ * --------------------
+ *  returns: 1 if both engines hold the same stored cells, else 0
+ */
+int engine_equal(const Engine *a, const Engine *b) {
+    if (a->hi - a->lo != b->hi - b->lo || a->lo % 64 != b->lo % 64) return 0;
+    size_t words = (size_t)((a->hi - 1) / 64 - a->lo / 64 + 1);
+    return memcmp(a->row + a->lo / 64, b->row + b->lo / 64, words * sizeof(uint64_t)) == 0;
+}
+
+/*
+ * Function:  engine_get
+ * --------------------
+ *  x:          cell index, 0 is the first cell of the seeded row
+ *
+ *  returns: state of the cell
+ */
+int engine_get(const Engine *e, long long x) {
+    long long p = e->origin + x;
+    if (p < e->lo || p >= e->hi) return e->background;
+    return get_bit(e->row, p);
+}
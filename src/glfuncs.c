@@ -0,0 +1,70 @@
+#include <SDL2/SDL.h>
+#include <stdio.h>
+
+#include "glfuncs.h"
+
+#define X(type, name) type p##name;
+GL_FUNCS(X)
+GL_INSTANCING_FUNCS(X)
+GL_CAPTURE_FUNCS(X)
+#undef X
+
+// stored through a void pointer, ISO C has no cast from object pointers
+// to function pointers
+#define X(type, name) \
+    if (!(*(void **) &p##name = SDL_GL_GetProcAddress(#name))) return #name;
+
+/*
+ * Function:  gl_load
+ * --------------------
+ * looks up the entry points in GL_FUNCS, needs a current context
+ *
+ *  returns: NULL on success, or the name of a missing function
+ */
+const char *gl_load(void) {
+    GL_FUNCS(X)
+    return NULL;
+}
+
+static const char *load_instancing(void) {
+    GL_INSTANCING_FUNCS(X)
+    return NULL;
+}
+
+static const char *load_capture(void) {
+    GL_CAPTURE_FUNCS(X)
+    return NULL;
+}
+
+#undef X
+
+// drivers may hand out functions they can't run, so the context version
+// is checked before an optional group is used
+static int has_version(int want_major, int want_minor) {
+    int major = 0, minor = 0;
+    const char *version = (const char *) glGetString(GL_VERSION);
+    if (!version || sscanf(version, "%d.%d", &major, &minor) != 2) return 0;
+    return major > want_major || (major == want_major && minor >= want_minor);
+}
+
+/*
+ * Function:  gl_load_instancing
+ * --------------------
+ * looks up the entry points in GL_INSTANCING_FUNCS
+ *
+ *  returns: 0 if they can be used, -1 otherwise
+ */
+int gl_load_instancing(void) {
+    return has_version(3, 3) && !load_instancing() ? 0 : -1;
+}
+
+/*
+ * Function:  gl_load_capture
+ * --------------------
+ * looks up the entry points in GL_CAPTURE_FUNCS
+ *
+ *  returns: 0 if they can be used, -1 otherwise
+ */
+int gl_load_capture(void) {
+    return has_version(3, 2) && !load_capture() ? 0 : -1;
+}
@@ -1,10 +1,18 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_opengl.h>
+#include <stdatomic.h>
 #include <stdio.h>
 
+#include "arena.h"
 #include "automata.h"
 #include "renderer.h"
 #include "microui.h"
+#include "engine.h"
+#include "recorder.h"
+#include "seed.h"
+#include "cli.h"
+#include "thumbs.h"
+#include "uicache.h"
 
 mu_Context *ctx;
 
@@ -12,16 +20,203 @@ mu_Context *ctx;
 static  float bg[3] = { 255, 255, 255 };
 static   char ruleStr[4] = "30";
 static   char cellSizeStr[4] = "5";
+static   char initStr[64] = "0.5";
+static   char seedStr[21] = "1";
+static   char recordStr[64] = "capture.gif";
+
+// size of the window, it follows resizes
+static    int screenWidth = SCREEN_WIDTH;
+static    int screenHeight = SCREEN_HEIGHT;
+
+// recording of the window, NULL when not recording
+static Recorder *recorder;
+
+// rule thumbnails, started the first time the rule browser is opened
+static Thumbs *thumbs;
+static    int openRules;
+
+/* everything the simulation allocates: the rows, the grid, the row queue
+ * and the initial row. It is reset whenever the settings change, by
+ * applySeed with the worker stopped; while the worker runs only it
+ * allocates from it. */
+static Arena simArena;
+
+// row storage, cells[i + cellsOrigin] is drawn in screen column i
 static    int *cells;
+static    int *nextCells;
+static    int cellsLen;
+static    int cellsCap;
+static    int cellsOrigin;
+static    int background;
+
+// states of the cells on screen, one byte each, drawn in one call
+static unsigned char *cellGrid;
+static    int cellGridCap;
+
+/*
+ * The grid is computed on a worker thread so a big one doesn't stall the
+ * window. Finished rows pass through a single producer, single consumer
+ * ring: the worker only moves rowHead and the render thread only moves
+ * rowTail. The worker sleeps on rowSpace while the ring is full and
+ * pushes an SDL_USEREVENT when the render thread may be waiting for input
+ * with the ring empty. Each side only posts when the other may be asleep,
+ * the worker after filling an empty ring and the render thread after
+ * draining a full one, and clears posts it didn't wait for before it
+ * sleeps, so a wait always sleeps until there is something to do.
+ */
+#define ROW_QUEUE_SLOTS 64
+
+static SDL_Thread *simThread;
+static atomic_int simCancel;
+static atomic_size_t rowHead, rowTail;
+static SDL_sem *rowSpace, *rowFilled;
+static unsigned char *rowQueue;
+static    int rowQueueCap;
+static    int simFirst;         /* first generation the worker computes */
+static    int simRows;          /* generations in the grid being computed */
+static    int rowsDone;         /* generations copied into the grid */
+static    int waitForRows;      /* draw only finished grids, for screenshots */
+
+// takes the posts made while nobody was waiting off a semaphore
+static void clearPosts(SDL_sem *sem) {
+    while (SDL_SemTryWait(sem) == 0) {}
+}
+
+static  void startSimulation(int first, int rows);
+static  void stopSimulation(void);
+static   int drainRows(int wait);
+
+// what has to be redrawn: the grid only changes when the settings do, and
+// a frame whose gui commands hash the same as the last one is skipped
+static    int cellsChanged = 1;
+static    int redrawNeeded = 1;
+static uint64_t lastCommandHash;
 
 // initial values for cellular automata
 static    int ruleset = 30;
 static    int CELL_SIZE = 5;
 static    int NUM_CELLS;
+static Boundary boundary = BOUNDARY_PERIODIC;
+static Boundary boundaryChoice = BOUNDARY_PERIODIC;
+
+// initial row, packed NUM_CELLS cells built when Render is pressed
+static uint64_t *seedWords;
+static SeedKind seedChoice = SEED_SINGLE;
+static SeedSpec seedSpec = { SEED_SINGLE, 0.5, 1, initStr };
+
+/*
+ * Function:  applySeed
+ * --------------------
+ * generates the initial row from the settings window, falling back to a
+ * single cell if the generator can't be used
+ *
+ */
+static void applySeed(void) {
+    stopSimulation();
+
+    // nothing computed for the old settings is needed any more
+    arena_reset(&simArena);
+    cells = nextCells = NULL;
+    cellsCap = 0;
+    cellGrid = rowQueue = NULL;
+    cellGridCap = rowQueueCap = 0;
+    seedSpec.kind = seedChoice;
+    seedSpec.seed = strtoull(seedStr, NULL, 10);
+    seedSpec.density = mu_clamp(atof(initStr), 0.0, 1.0);
+
+    seedWords = (uint64_t *)arena_alloc(&simArena, ((NUM_CELLS + 63) / 64 + 1) * sizeof(uint64_t));
+    if (seed_fill(&seedSpec, seedWords, NUM_CELLS) != 0) {
+        fprintf(stderr, "can't seed with %s '%s', using a single cell\n",
+                seed_name(seedSpec.kind), initStr);
+        seedSpec.kind = SEED_SINGLE;
+        seed_fill(&seedSpec, seedWords, NUM_CELLS);
+    }
+    cellsChanged = 1;
+}
+
+/*
+ * Function:  applySettings
+ * --------------------
+ * takes the values typed into the settings window, as the Render button
+ * does
+ *
+ */
+static void applySettings(void) {
+    stopSimulation();
+    boundary = boundaryChoice;
+    ruleset = (atoi(ruleStr) == 0) ? ruleset : atoi(ruleStr);
+    CELL_SIZE = (atoi(cellSizeStr) == 0) ? CELL_SIZE : atoi(cellSizeStr);
+    NUM_CELLS = screenWidth / CELL_SIZE;
+    applySeed();
+}
+
+// queues a captured frame, dropping it rather than stalling the window
+static void recordFrame(const unsigned char *rgba, int width, int height, void *udata) {
+    recorder_push(udata, rgba, 0);
+}
+
+/*
+ * Function:  toggleRecording
+ * --------------------
+ * starts recording every frame to the file named in the settings window,
+ * or finishes the recording and reports how it went
+ *
+ */
+static void toggleRecording(void) {
+    RecordStatus status;
+
+    if (!recorder) {
+        recorder = recorder_open(recordStr, screenWidth, screenHeight, 30, 8);
+        if (!recorder) {
+            fprintf(stderr, "can't record to %s\n", recordStr);
+        } else if (r_capture_start(recordFrame, recorder) != 0) {
+            fprintf(stderr, "recording needs OpenGL 3.2\n");
+            recorder_close(recorder, NULL);
+            recorder = NULL;
+        }
+        return;
+    }
+
+    r_capture_stop();
+    if (recorder_close(recorder, &status) != 0)
+        fprintf(stderr, "error writing %s\n", recordStr);
+    else
+        fprintf(stderr, "recorded %llu frames to %s, %llu dropped, queue depth up to %d of %d\n",
+                (unsigned long long)status.written, recordStr,
+                (unsigned long long)status.dropped, status.max_queued, status.slots);
+    recorder = NULL;
+}
+
+/*
+ * Function:  resizeWindow
+ * --------------------
+ * follows a change in the size of the window. A taller window only needs
+ * more generations, which renderAutomata adds to the grid; a change in
+ * the number of cells across starts the automaton over, since the
+ * boundaries and the initial row depend on the row width.
+ *
+ */
+static void resizeWindow(int width, int height) {
+    if (width == screenWidth && height == screenHeight) return;
+
+    // a recording keeps the size it was started with
+    if (recorder) {
+        fprintf(stderr, "window resized, stopping the recording\n");
+        toggleRecording();
+    }
+    screenWidth = width;
+    screenHeight = height;
+    r_resize(width, height);
+
+    if (screenWidth / CELL_SIZE != NUM_CELLS) {
+        NUM_CELLS = screenWidth / CELL_SIZE;
+        applySeed();
+    }
+}
 
 // sample ui window
 static void settings_window(mu_Context *ctx) {
-    if (mu_begin_window(ctx, "Configure", mu_rect(10, 10, 145, 105))) {
+    if (mu_begin_window(ctx, "Configure", mu_rect(10, 10, 200, 253))) {
         mu_layout_row(ctx, 2, (int[]) { 60, -1 }, 0);
 
         mu_label(ctx, "Ruleset");
@@ -30,10 +225,107 @@ static void settings_window(mu_Context *ctx) {
         mu_label(ctx, "Cell Size");
         mu_textbox(ctx, cellSizeStr, sizeof(cellSizeStr));
 
-        if (mu_button(ctx, "Render")) {
-            ruleset = (atoi(ruleStr) == 0) ? ruleset : atoi(ruleStr);
-            CELL_SIZE = (atoi(cellSizeStr) == 0) ? CELL_SIZE : atoi(cellSizeStr);
-            NUM_CELLS = SCREEN_WIDTH / CELL_SIZE;
+        mu_label(ctx, "Boundary");
+        if (mu_button(ctx, boundary_name(boundaryChoice)))
+            boundaryChoice = (boundaryChoice + 1) % BOUNDARY_COUNT;
+
+        // density for random, cells for pattern and string, path for file
+        mu_label(ctx, "Initial");
+        if (mu_button(ctx, seed_name(seedChoice)))
+            seedChoice = (seedChoice + 1) % SEED_COUNT;
+        mu_label(ctx, "");
+        mu_textbox(ctx, initStr, sizeof(initStr));
+        mu_label(ctx, "Seed");
+        mu_textbox(ctx, seedStr, sizeof(seedStr));
+
+        mu_label(ctx, "Record");
+        mu_textbox(ctx, recordStr, sizeof(recordStr));
+
+        mu_layout_row(ctx, 3, (int[]) { 60, 60, -1 }, 0);
+        if (mu_button(ctx, "Render")) applySettings();
+        if (mu_button(ctx, recorder ? "Stop" : "Record")) toggleRecording();
+        if (mu_button(ctx, "Rules")) openRules = 1;
+
+        // frames still waiting for the writer thread, and frames lost
+        // because it fell behind
+        if (recorder) {
+            RecordStatus status;
+            char buf[64];
+            recorder_status(recorder, &status);
+            snprintf(buf, sizeof(buf), "%llu frames, %d queued, %llu dropped",
+                     (unsigned long long)(status.written + status.queued),
+                     status.queued, (unsigned long long)status.dropped);
+            mu_layout_row(ctx, 1, (int[]) { -1 }, 0);
+            mu_label(ctx, buf);
+        }
+        mu_end_window(ctx);
+    }
+}
+
+// copies a finished thumbnail into the texture
+static void uploadThumb(int rule, const unsigned char *pixels, int size, void *udata) {
+    r_set_thumb(rule, pixels);
+}
+
+/*
+ * Function:  ruleThumb
+ * --------------------
+ * a button showing the thumbnail of a rule, framed while hovered and
+ * while it is the rule on screen
+ *
+ *  returns: 1 if it was clicked
+ */
+static int ruleThumb(mu_Context *ctx, int rule) {
+    mu_Id id = mu_get_id(ctx, &rule, sizeof(rule));
+    mu_Rect r = mu_layout_next(ctx);
+    mu_update_control(ctx, id, r, 0);
+
+    mu_draw_rect(ctx, r, mu_color(255, 255, 255, 255));
+    mu_draw_icon(ctx, R_ICON_THUMB + rule, r, mu_color(0, 0, 0, 255));
+    if (ctx->hover == id)
+        mu_draw_box(ctx, mu_rect(r.x - 1, r.y - 1, r.w + 2, r.h + 2), ctx->style->colors[MU_COLOR_BUTTONHOVER]);
+    if (rule == ruleset)
+        mu_draw_box(ctx, mu_rect(r.x - 2, r.y - 2, r.w + 4, r.h + 4), ctx->style->colors[MU_COLOR_BUTTONFOCUS]);
+
+    return ctx->mouse_pressed == MU_MOUSE_LEFT && ctx->focus == id;
+}
+
+/*
+ * Function:  rules_window
+ * --------------------
+ * shows every rule run from a single cell, clicking one renders it. The
+ * thumbnails are drawn by worker threads and appear as they finish.
+ *
+ */
+static void rules_window(mu_Context *ctx) {
+    if (openRules) {
+        mu_Container *cnt = mu_get_container(ctx, "Rules");
+        cnt->open = 1;
+        mu_bring_to_front(ctx, cnt);
+        if (!thumbs) thumbs = thumbs_start(R_THUMB_SIZE, 0);
+        openRules = 0;
+    }
+
+    if (mu_begin_window_ex(ctx, "Rules", mu_rect(220, 10, 390, 420), MU_OPT_CLOSED)) {
+        char buf[64];
+        int rule, pending = thumbs ? thumbs_pending(thumbs) : 0;
+
+        mu_layout_row(ctx, 1, (int[]) { -1 }, 0);
+        if (pending) snprintf(buf, sizeof(buf), "Rule %d, drawing %d more", ruleset, pending);
+        else         snprintf(buf, sizeof(buf), "Rule %d", ruleset);
+        mu_label(ctx, buf);
+
+        mu_layout_row(ctx, 8, (int[]) { R_THUMB_SIZE, R_THUMB_SIZE, R_THUMB_SIZE, R_THUMB_SIZE,
+                                        R_THUMB_SIZE, R_THUMB_SIZE, R_THUMB_SIZE, R_THUMB_SIZE },
+                      R_THUMB_SIZE);
+        for (rule = 0; rule < THUMB_RULES; rule++) {
+            if (ruleThumb(ctx, rule)) {
+                // applySettings keeps the last rule when the text reads 0
+                stopSimulation();
+                ruleset = rule;
+                snprintf(ruleStr, sizeof(ruleStr), "%d", rule);
+                applySettings();
+            }
         }
         mu_end_window(ctx);
     }
@@ -43,6 +335,7 @@ static void settings_window(mu_Context *ctx) {
 static void process_frame(mu_Context *ctx) {
     mu_begin(ctx);
     settings_window(ctx);
+    rules_window(ctx);
     mu_end(ctx);
 }
 
@@ -78,6 +371,152 @@ static int text_height(mu_Font font) {
 }
 
 
+// FNV-1a of the gui command list, which holds everything microui draws
+static uint64_t commandHash(mu_Context *ctx) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    for (int i = 0; i < ctx->command_list.idx; i++) {
+        h ^= (unsigned char) ctx->command_list.items[i];
+        h *= 0x100000001b3ull;
+    }
+    return h;
+}
+
+/*
+ * Function:  drawFrame
+ * --------------------
+ * runs the gui and draws a frame of the automaton and the gui, unless
+ * nothing on screen would change
+ *
+ *  force:      draw even if nothing changed, e.g. when capturing
+ *
+ *  returns: 1 if a frame was drawn, 0 if it was skipped
+ */
+static int drawFrame(int force) {
+    // thumbnails and rows that finished since the last frame, the workers
+    // wake the loop with an SDL_USEREVENT
+    if (thumbs && thumbs_poll(thumbs, uploadThumb, NULL)) redrawNeeded = 1;
+    if (drainRows(0)) redrawNeeded = 1;
+    process_frame(ctx);
+
+    uint64_t hash = commandHash(ctx);
+    if (!force && !redrawNeeded && !cellsChanged && hash == lastCommandHash) return 0;
+    lastCommandHash = hash;
+    redrawNeeded = 0;
+
+    // gui rendering
+    r_clear(mu_color(bg[0], bg[1], bg[2], 255));
+    renderAutomata();
+
+    ui_draw(ctx);
+    r_present();
+    return 1;
+}
+
+// sets up microui and the initial cells
+static void initViewer(void) {
+    ctx = malloc(sizeof(mu_Context));
+    mu_init(ctx);
+    ctx->text_width = text_width;
+    ctx->text_height = text_height;
+
+    arena_init(&simArena, 1 << 20);
+    NUM_CELLS = screenWidth / CELL_SIZE;
+    applySeed();
+}
+
+typedef struct {
+    const char *path;           /* file name, may hold a %d for the frame */
+    int         frame;
+} Screenshot;
+
+// writes a captured frame as a binary PPM
+static void saveScreenshot(const unsigned char *rgba, int width, int height, void *udata) {
+    Screenshot *shot = udata;
+    char path[1024];
+    int i;
+
+    snprintf(path, sizeof(path), shot->path, shot->frame++);
+    FILE *f = fopen(path, "wb");
+    if (!f) {
+        fprintf(stderr, "can't write %s\n", path);
+        return;
+    }
+    fprintf(f, "P6\n%d %d\n255\n", width, height);
+    for (i = 0; i < width * height; i++) fwrite(rgba + i * 4, 1, 3, f);
+    fclose(f);
+}
+
+/*
+ * Function:  runScreenshot
+ * --------------------
+ * renders the viewer offscreen for a number of frames and saves them,
+ * for image capture without a display. The settings window is shown as
+ * it would be after pressing Render with the given options.
+ *
+ *  returns: process exit status
+ */
+static int runScreenshot(int argc, char **argv) {
+    Screenshot shot = { NULL, 1 };
+    SeedSpec spec;
+    int i, frames = 3;          /* microui lays the window out over the first two */
+
+    for (i = 1; i + 1 < argc; i += 2) {
+        const char *arg = argv[i], *val = argv[i + 1];
+        if (strcmp(arg, "--screenshot") == 0) {
+            shot.path = val;
+        } else if (strcmp(arg, "--frames") == 0) {
+            frames = atoi(val);
+        } else if (strcmp(arg, "--rule") == 0) {
+            snprintf(ruleStr, sizeof(ruleStr), "%s", val);
+        } else if (strcmp(arg, "--cell-size") == 0) {
+            snprintf(cellSizeStr, sizeof(cellSizeStr), "%s", val);
+        } else if (strcmp(arg, "--boundary") == 0 && boundary_parse(val) >= 0) {
+            boundaryChoice = boundary_parse(val);
+        } else if (strcmp(arg, "--init") == 0 && seed_parse(&spec, val) == 0) {
+            seedChoice = spec.kind;
+            if (spec.text) snprintf(initStr, sizeof(initStr), "%s", spec.text);
+        } else if (strcmp(arg, "--seed") == 0) {
+            snprintf(seedStr, sizeof(seedStr), "%s", val);
+        } else {
+            fprintf(stderr, "bad screenshot option '%s %s'\n", arg, val);
+            return EXIT_FAILURE;
+        }
+    }
+    if (i < argc || frames < 1) {
+        fprintf(stderr, "usage: simulate --screenshot FILE [--frames N (default 3)] [--rule N] [--cell-size N]\n"
+                        "                [--boundary MODE] [--init SPEC] [--seed N]\n");
+        return EXIT_FAILURE;
+    }
+
+    // fall back to SDL's display-less driver when there is no display
+    if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+        SDL_setenv("SDL_VIDEODRIVER", "offscreen", 1);
+        if (SDL_Init(SDL_INIT_VIDEO) != 0) {
+            fprintf(stderr, "can't start SDL: %s\n", SDL_GetError());
+            return EXIT_FAILURE;
+        }
+    }
+    if (r_init_offscreen() != 0 || r_capture_start(saveScreenshot, &shot) != 0) {
+        fprintf(stderr, "offscreen rendering needs OpenGL 3.2\n");
+        return EXIT_FAILURE;
+    }
+
+    initViewer();
+    applySettings();
+    waitForRows = 1;
+    for (i = 0; i < frames; i++) drawFrame(1);
+    r_capture_stop();
+    stopSimulation();
+
+    arena_free(&simArena);
+    thumbs_free(thumbs);
+    ui_free();
+    free(ctx);
+    SDL_Quit();
+    return EXIT_SUCCESS;
+}
+
+
 /* -------------
  *
  * MAIN FUNCTION
@@ -85,58 +524,61 @@ static int text_height(mu_Font font) {
  * -------------
  * */
 
-int main(void) {
+int main(int argc, char **argv) {
+
+    // --screenshot renders the viewer offscreen, other arguments run the
+    // simulation headless
+    for (int i = 1; i < argc; i++)
+        if (strcmp(argv[i], "--screenshot") == 0) return runScreenshot(argc, argv);
+    if (argc > 1) return cli_main(argc, argv);
 
     // SDL
     SDL_Init(SDL_INIT_EVERYTHING);
     r_init();
-
-    // microui
-    ctx = malloc(sizeof(mu_Context));
-    mu_init(ctx);
-    ctx->text_width = text_width;
-    ctx->text_height = text_height;
-
-    // initial cells
-    NUM_CELLS = SCREEN_WIDTH / CELL_SIZE;
-    cells = (int *)malloc(NUM_CELLS * sizeof(int));
-    for (int i = 0; i < NUM_CELLS; i++) cells[i] = 0;
+    initViewer();
 
     // Main loop
     for (;;) {
         // Input handling
         handleEvents();
-        process_frame(ctx);
-
-        // gui rendering
-        r_clear(mu_color(bg[0], bg[1], bg[2], 255));
-        renderAutomata();
-
-        mu_Command *cmd = NULL;
-        while (mu_next_command(ctx, &cmd)) {
-            switch (cmd->type) {
-                case MU_COMMAND_TEXT: r_draw_text(cmd->text.str, cmd->text.pos, cmd->text.color); break;
-                case MU_COMMAND_RECT: r_draw_rect(cmd->rect.rect, cmd->rect.color); break;
-                case MU_COMMAND_ICON: r_draw_icon(cmd->icon.id, cmd->icon.rect, cmd->icon.color); break;
-                case MU_COMMAND_CLIP: r_set_clip_rect(cmd->clip.rect); break;
-            }
-        }
 
-        r_present();
+        // sleep until the next event when the last frame was unchanged,
+        // a recording keeps every frame so it plays back in real time
+        if (!drawFrame(recorder != NULL)) SDL_WaitEvent(NULL);
     }
 
-    free(cells);
+    arena_free(&simArena);
+    thumbs_free(thumbs);
+    ui_free();
     free(ctx);
     return 0;
 }
 
 
+// new state for each neighbourhood 4*left + 2*curr + right, see ruleTable
+static unsigned char rules[8];
+static    int rulesFor = -1;
+
+/*
+ * Function:  ruleTable
+ * --------------------
+ * rebuilds the lookup table of new states when the ruleset has changed
+ * since the last call, so each cell costs a single table read
+ *
+ */
+static void ruleTable(void) {
+    int i;
+    if (rulesFor == ruleset) return;
+    for (i = 0; i < 8; i++)
+        rules[i] = (ruleset >> i) & 1;
+    rulesFor = ruleset;
+}
+
 /*
  * Function:  calculateState
  * --------------------
  * Finds state between current, left, and right neighbors
  *
- *  ruleset:    decimal value indicating the rules
  *  left:       left neighbor
  *  curr:       current neightbor
  *  right:      right neighbor
@@ -144,84 +586,308 @@ int main(void) {
  *  returns: integer representing the new state of curr
  */
 int calculateState(int left, int curr, int right) {
-    int value, pos, dec;
-    int rules[] = {0, 0, 0, 0, 0, 0, 0, 0, 0};
-
-    value = 7 - ((left*4) + (curr*2) + right); /* used for position */
-    pos = 7;
-    dec = ruleset;
-
-    // fill array with value
-    while (dec != 0) {
-        rules[pos] = dec % 2;
-        dec /= 2;
-        pos--;
-    }
+    ruleTable();
+    return rules[(left*4) + (curr*2) + right];
+}
 
-    return rules[value];
+/*
+ * Function:  reserveCells
+ * --------------------
+ * makes room for at least n stored cells, growing the row buffers by
+ * doubling so a growing row reallocates only O(log n) times. The old
+ * buffers stay in the arena until its next reset, at most as much again.
+ *
+ *  n:          number of cells to hold
+ *
+ */
+static void reserveCells(int n) {
+    if (n <= cellsCap) return;
+
+    int cap = cellsCap ? cellsCap : 64;
+    while (cap < n) cap *= 2;
+    int *grown = (int *)arena_alloc(&simArena, cap * sizeof(int));
+    if (cells) memcpy(grown, cells, cellsLen * sizeof(int));
+    cells = grown;
+    nextCells = (int *)arena_alloc(&simArena, cap * sizeof(int));
+    cellsCap = cap;
+}
+
+/*
+ * Function:  cellAt
+ * --------------------
+ * reads a stored cell, treating everything outside the stored row as the
+ * background state (only used at the edges of the row)
+ *
+ *  i:          index into cells
+ *
+ *  returns: state of the cell
+ */
+static int cellAt(int i) {
+    return (i >= 0 && i < cellsLen) ? cells[i] : background;
 }
 
 /*
  * Function:  getNextGeneration
  * --------------------
- * changes cells into the next generation, using a ruleset number
+ * changes cells into the next generation, using a ruleset number and the
+ * current boundary condition
  *
  */
 void getNextGeneration(void) {
-    int i;
-    int *newCells = (int* )malloc(NUM_CELLS * sizeof(int));
-    for (i = 1; i < NUM_CELLS-1; i++) {
-        // calculate the state
-        newCells[i] = calculateState(cells[i - 1], cells[i], cells[i + 1]);
-    }
+    int i, left, right, *tmp;
+    int n = cellsLen;
+    unsigned pattern = 0;
+
+    ruleTable();
+    if (boundary == BOUNDARY_GROW) {
+        // the light cone widens by one cell on each side, cell i moves to i + 1
+        reserveCells(n + 2);
+        if (n > 1) pattern = (cells[0] << 1) | cells[1];
+        for (i = 2; i < n; i++) {
+            pattern = ((pattern << 1) | cells[i]) & 7;
+            nextCells[i] = rules[pattern];
+        }
+        nextCells[0]     = calculateState(background, cellAt(-1), cellAt(0));
+        nextCells[1]     = calculateState(cellAt(-1), cellAt(0), cellAt(1));
+        nextCells[n]     = calculateState(cellAt(n - 2), cellAt(n - 1), background);
+        nextCells[n + 1] = calculateState(cellAt(n - 1), background, background);
+
+        cellsLen += 2;
+        cellsOrigin += 1;
+        background = calculateState(background, background, background);
+    } else {
+        // state just past each edge of the row
+        switch (boundary) {
+            case BOUNDARY_FIXED0:  left = 0;            right = 0;            break;
+            case BOUNDARY_FIXED1:  left = 1;            right = 1;            break;
+            case BOUNDARY_REFLECT: left = cells[0];     right = cells[n - 1]; break;
+            default:               left = cells[n - 1]; right = cells[0];     break;
+        }
+
+        // slide the 3 cell neighbourhood along the row
+        pattern = (cells[0] << 1) | (n > 1 ? cells[1] : 0);
+        for (i = 1; i < n - 1; i++) {
+            pattern = ((pattern << 1) | cells[i + 1]) & 7;
+            nextCells[i] = rules[pattern];
+        }
 
-    // include wrap around
-    newCells[0] = calculateState(cells[NUM_CELLS-1], cells[0], cells[1]);
-    newCells[NUM_CELLS - 1] = calculateState(cells[NUM_CELLS - 2],
-            cells[NUM_CELLS - 1], cells[0]);
+        if (n == 1) {
+            nextCells[0] = calculateState(left, cells[0], right);
+        } else {
+            nextCells[0] = calculateState(left, cells[0], cells[1]);
+            nextCells[n - 1] = calculateState(cells[n - 2], cells[n - 1], right);
+        }
+    }
 
-    // replace old cells to new cells
-    for (i = 0; i < NUM_CELLS; i++) cells[i] = newCells[i];
-    free(newCells);
+    // swap old cells with new cells
+    tmp = cells;
+    cells = nextCells;
+    nextCells = tmp;
 }
 
 /*
  * Function:  drawGeneration
  * --------------------
- * draws cells into the screen
+ * stores the cells of the current generation as a row of the screen grid
  *
- *  row:        row (in pixels) for the cells to occupy
+ *  states:     NUM_CELLS bytes for the row
  *
  */
-void drawGeneration(int row) {
+void drawGeneration(unsigned char *states) {
+    int i;
+    for (i = 0; i < NUM_CELLS; i++)
+        states[i] = cellAt(i + cellsOrigin);
+}
+
+// sets up the stored row from the initial row
+static void seedCells(void) {
     int i;
-    for (i = 0; i < NUM_CELLS; i++) {
-        int color = 255 - (255 * cells[i]);
-        r_draw_rect(mu_rect(i * CELL_SIZE, row, CELL_SIZE, CELL_SIZE),
-                    mu_color(color, color, color, 255));
+
+    background = 0;
+    if (boundary == BOUNDARY_GROW && seedSpec.kind == SEED_SINGLE) {
+        // only the seed is stored, everything else is background
+        reserveCells(1);
+        cellsLen = 1;
+        cellsOrigin = -(NUM_CELLS / 2);
+        cells[0] = 1;
+    } else {
+        reserveCells(NUM_CELLS);
+        cellsLen = NUM_CELLS;
+        cellsOrigin = 0;
+        for (i = 0; i < NUM_CELLS; i++)
+            cells[i] = (seedWords[i / 64] >> (i % 64)) & 1;
     }
 }
 
 /*
- * Function:  renderAutomata
+ * Function:  simulate
  * --------------------
- * Handles rendering the pattern
+ * worker thread, runs the automaton from the initial row and queues each
+ * generation that fits on screen until done or cancelled. It is the only
+ * thread touching the stored row while it runs, and the settings it reads
+ * only change after stopSimulation.
  *
  */
-void renderAutomata(void) {
-    int i;
-    cells = (int *)malloc(NUM_CELLS * sizeof(int));
-    for (i = 0; i < NUM_CELLS; i++)
-        cells[i] = 0;
-    cells[NUM_CELLS / 2] = 1;
+static int simulate(void *data) {
+    size_t head;
+    SDL_Event event;
 
-    int y = 0;
-    while (y < SCREEN_HEIGHT) {
-        drawGeneration(y);
+    if (simFirst == 0) seedCells();
+    for (int row = simFirst; row < simRows; row++) {
+        head = atomic_load_explicit(&rowHead, memory_order_relaxed);
+        while (head - atomic_load_explicit(&rowTail, memory_order_acquire) == ROW_QUEUE_SLOTS) {
+            if (atomic_load(&simCancel)) return 0;
+            clearPosts(rowSpace);
+            if (head - atomic_load(&rowTail) == ROW_QUEUE_SLOTS && !atomic_load(&simCancel))
+                SDL_SemWait(rowSpace);
+        }
+        if (atomic_load_explicit(&simCancel, memory_order_relaxed)) return 0;
+
+        drawGeneration(rowQueue + (head % ROW_QUEUE_SLOTS) * NUM_CELLS);
         getNextGeneration();
-        y += CELL_SIZE;
+
+        /* sequentially consistent with drainRows, so if the render thread
+         * found the ring empty before this row, this sees its tail */
+        atomic_store(&rowHead, head + 1);
+        if (atomic_load(&rowTail) == head) {
+            SDL_SemPost(rowFilled);
+            memset(&event, 0, sizeof(event));
+            event.type = SDL_USEREVENT;
+            SDL_PushEvent(&event);
+        }
+    }
+    return 0;
+}
+
+/*
+ * Function:  startSimulation
+ * --------------------
+ * starts computing generations on the worker thread, or right away if the
+ * thread can't be started. The grid grows by doubling, so it is rarely
+ * reallocated while the window is resized.
+ *
+ *  first:      first generation to compute, 0 to start from the initial
+ *              row, otherwise the stored row must hold that generation
+ *  rows:       generations that fit on screen
+ *
+ */
+static void startSimulation(int first, int rows) {
+    stopSimulation();
+
+    if (rows * NUM_CELLS > cellGridCap) {
+        int cap = cellGridCap ? cellGridCap : 4096;
+        while (cap < rows * NUM_CELLS) cap *= 2;
+        cellGrid = (unsigned char *)arena_grow(&simArena, cellGrid, cellGridCap, cap);
+        cellGridCap = cap;
+    }
+    memset(cellGrid + first * NUM_CELLS, 0, (rows - first) * NUM_CELLS);
+    if (ROW_QUEUE_SLOTS * NUM_CELLS > rowQueueCap) {
+        int cap = rowQueueCap ? rowQueueCap : ROW_QUEUE_SLOTS * 64;
+        while (cap < ROW_QUEUE_SLOTS * NUM_CELLS) cap *= 2;
+        rowQueue = (unsigned char *)arena_alloc(&simArena, cap);
+        rowQueueCap = cap;
+    }
+    if (!rowSpace) {
+        rowSpace = SDL_CreateSemaphore(0);
+        rowFilled = SDL_CreateSemaphore(0);
+    }
+    clearPosts(rowSpace);
+    clearPosts(rowFilled);
+
+    atomic_store(&rowHead, 0);
+    atomic_store(&rowTail, 0);
+    atomic_store(&simCancel, 0);
+    simFirst = first;
+    simRows = rows;
+    rowsDone = first;
+
+    simThread = SDL_CreateThread(simulate, "simulate", NULL);
+    if (!simThread) {
+        if (first == 0) seedCells();
+        for (; rowsDone < rows; rowsDone++) {
+            drawGeneration(cellGrid + rowsDone * NUM_CELLS);
+            getNextGeneration();
+        }
+    }
+}
+
+/*
+ * Function:  stopSimulation
+ * --------------------
+ * cancels the worker and waits until it has let go of the stored row.
+ * The rows it queued are kept, so the stored row then holds generation
+ * rowsDone.
+ *
+ */
+static void stopSimulation(void) {
+    if (!simThread) return;
+    atomic_store(&simCancel, 1);
+    SDL_SemPost(rowSpace);
+    SDL_WaitThread(simThread, NULL);
+    drainRows(0);
+    simThread = NULL;
+}
+
+/*
+ * Function:  drainRows
+ * --------------------
+ * copies the rows the worker has queued into the grid
+ *
+ *  wait:       keep waiting for rows until the grid is complete
+ *
+ *  returns: number of rows copied
+ */
+static int drainRows(int wait) {
+    size_t head, tail;
+    int n = 0;
+
+    while (simThread && rowsDone < simRows) {
+        tail = atomic_load_explicit(&rowTail, memory_order_relaxed);
+        head = atomic_load(&rowHead);
+        if (head == tail) {
+            if (!wait) break;
+            clearPosts(rowFilled);
+            if (atomic_load(&rowHead) == tail) SDL_SemWait(rowFilled);
+            continue;
+        }
+
+        size_t first = tail;
+        for (; tail != head; tail++, n++)
+            memcpy(cellGrid + rowsDone++ * NUM_CELLS,
+                   rowQueue + (tail % ROW_QUEUE_SLOTS) * NUM_CELLS, NUM_CELLS);
+
+        /* sequentially consistent with the worker, so if it found the ring
+         * full before this drain, this sees the row that filled it */
+        atomic_store(&rowTail, tail);
+        if (atomic_load(&rowHead) - first == ROW_QUEUE_SLOTS) SDL_SemPost(rowSpace);
+    }
+    return n;
+}
+
+/*
+ * Function:  renderAutomata
+ * --------------------
+ * Handles rendering the pattern, the generations are only computed again
+ * after the settings change. They fill in as the worker thread finishes
+ * them, screenshots wait for all of them.
+ *
+ */
+void renderAutomata(void) {
+    if (NUM_CELLS < 1) return;
+
+    int rows = (screenHeight + CELL_SIZE - 1) / CELL_SIZE;
+    if (cellsChanged) {
+        startSimulation(0, rows);
+        cellsChanged = 0;
+    } else if (rows > simRows) {
+        // a taller window, carry on from the last generation computed
+        stopSimulation();
+        startSimulation(rowsDone, rows);
     }
+    drainRows(waitForRows);
 
+    r_draw_cells(cellGrid, NUM_CELLS, rows, CELL_SIZE,
+                 mu_color(255, 255, 255, 255), mu_color(0, 0, 0, 255));
 }
 
 /*
@@ -235,7 +901,15 @@ void handleEvents(void) {
     while (SDL_PollEvent(&event)) {
         switch (event.type) {
             case SDL_QUIT:
+                if (recorder) toggleRecording();
+                stopSimulation();
+                thumbs_free(thumbs);
                 exit(EXIT_SUCCESS); break;
+            case SDL_WINDOWEVENT:
+                if (event.window.event == SDL_WINDOWEVENT_SIZE_CHANGED)
+                    resizeWindow(event.window.data1, event.window.data2);
+                redrawNeeded = 1;
+                break;
             case SDL_MOUSEMOTION: mu_input_mousemove(ctx, event.motion.x, event.motion.y); break;
             case SDL_MOUSEWHEEL: mu_input_scroll(ctx, 0, event.wheel.y * -30); break;
             case SDL_TEXTINPUT: mu_input_text(ctx, event.text.text); break;
@@ -0,0 +1,143 @@
+#ifdef __linux__
+#define _GNU_SOURCE     /* pthread_setaffinity_np */
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+#include <SDL2/SDL.h>
+#include <stdlib.h>
+
+#include "pool.h"
+
+/*
+ * Each worker waits on its own semaphore, runs the job and posts done.
+ * The semaphores order the job's memory accesses with the caller's, so
+ * whatever the caller wrote before pool_run is visible to the workers and
+ * everything they wrote is visible once it returns. Worker k always gets
+ * the same k, so it can own the same part of the data on every run.
+ */
+struct Pool {
+    int             threads;
+    int             pin;
+    PoolFn          fn;
+    void           *arg;
+    int             quit;
+    SDL_sem        *go[POOL_MAX_THREADS];
+    SDL_sem        *done;
+    SDL_Thread     *thread[POOL_MAX_THREADS];
+    struct Worker {
+        Pool   *pool;
+        int     index;
+    } worker[POOL_MAX_THREADS];
+};
+
+/*
+ * Function:  pin_thread
+ * --------------------
+ * keeps the calling thread on one CPU, so the memory it touches first is
+ * placed on that CPU's NUMA node and stays local. Only done on Linux,
+ * where SDL threads are pthreads; elsewhere the scheduler decides.
+ *
+ */
+static void pin_thread(int cpu) {
+#ifdef __linux__
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    CPU_SET(cpu, &set);
+    pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+    (void)cpu;
+#endif
+}
+
+static int worker(void *data) {
+    struct Worker *w = data;
+    Pool *p = w->pool;
+
+    if (p->pin) pin_thread(w->index % SDL_GetCPUCount());
+    for (;;) {
+        SDL_SemWait(p->go[w->index]);
+        if (p->quit) break;
+        p->fn(p->arg, w->index, p->threads);
+        SDL_SemPost(p->done);
+    }
+    return 0;
+}
+
+/*
+ * Function:  pool_start
+ * --------------------
+ * starts the workers, which sleep until pool_run
+ *
+ *  threads:    number of workers, 0 for one per CPU
+ *  pin:        pin worker k to CPU k
+ *
+ *  returns: the pool, or NULL if out of memory or no thread started
+ */
+Pool *pool_start(int threads, int pin) {
+    Pool *p = calloc(1, sizeof(*p));
+    int i;
+
+    if (!p) return NULL;
+    p->pin = pin;
+    p->done = SDL_CreateSemaphore(0);
+    if (!p->done) {
+        free(p);
+        return NULL;
+    }
+
+    if (threads < 1) threads = SDL_GetCPUCount();
+    threads = threads < 1 ? 1 : threads > POOL_MAX_THREADS ? POOL_MAX_THREADS : threads;
+    for (i = 0; i < threads; i++) {
+        int k = p->threads;
+        p->worker[k].pool = p;
+        p->worker[k].index = k;
+        p->go[k] = SDL_CreateSemaphore(0);
+        if (!p->go[k]) break;
+        p->thread[k] = SDL_CreateThread(worker, "pool", &p->worker[k]);
+        if (!p->thread[k]) {
+            SDL_DestroySemaphore(p->go[k]);
+            break;
+        }
+        p->threads++;
+    }
+    if (!p->threads) {
+        pool_free(p);
+        return NULL;
+    }
+    return p;
+}
+
+int pool_size(const Pool *p) {
+    return p->threads;
+}
+
+/*
+ * Function:  pool_run
+ * --------------------
+ * calls fn(arg, k, n) on every worker k of the n in the pool and waits
+ * for all of them to return
+ *
+ */
+void pool_run(Pool *p, PoolFn fn, void *arg) {
+    int k;
+
+    p->fn = fn;
+    p->arg = arg;
+    for (k = 0; k < p->threads; k++) SDL_SemPost(p->go[k]);
+    for (k = 0; k < p->threads; k++) SDL_SemWait(p->done);
+}
+
+void pool_free(Pool *p) {
+    int k;
+
+    if (!p) return;
+    p->quit = 1;
+    for (k = 0; k < p->threads; k++) SDL_SemPost(p->go[k]);
+    for (k = 0; k < p->threads; k++) {
+        SDL_WaitThread(p->thread[k], NULL);
+        SDL_DestroySemaphore(p->go[k]);
+    }
+    SDL_DestroySemaphore(p->done);
+    free(p);
+}
@@ -0,0 +1,275 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "preimage.h"
+
+/*
+ * A preimage x of a row y is a walk through the rule's de Bruijn graph.
+ * Its 4 nodes are the pairs of neighboring cells v = 2a + b, and the
+ * edge from (a, b) to (b, c) is labeled with the rule's output for
+ * (a, b, c). x steps to y exactly when the walk through the nodes
+ * (x[i - 1], x[i]) for i = 0 to width follows the edges labeled y[0],
+ * y[1] and so on. The boundary decides which start and end nodes are
+ * allowed. With periodic rows the walk has to close on its start node,
+ * so all the searches below keep one lane per start node.
+ *
+ * A set of nodes is 4 bits. The 4 lanes of such sets, one per start
+ * node, are packed into 16 bits, with lane s in bits 4s to 4s + 3.
+ */
+
+static inline int cell(const uint64_t *row, size_t x) {
+    return (row[x / 64] >> (x % 64)) & 1;
+}
+
+// nodes reached from node v by an edge labeled y
+static inline int edges(int rule, int v, int y) {
+    int set = 0;
+    for (int c = 0; c < 2; c++)
+        if (((rule >> (2 * v + c)) & 1) == y) set |= 1 << (2 * (v & 1) + c);
+    return set;
+}
+
+/*
+ * Function:  allowed
+ * --------------------
+ *  returns: 1 if a walk may start on node s and end on node e under the
+ *           boundary, else 0
+ */
+static int allowed(Boundary boundary, int s, int e) {
+    switch (boundary) {
+        case BOUNDARY_FIXED0:  return (s >> 1) == 0 && (e & 1) == 0;
+        case BOUNDARY_FIXED1:  return (s >> 1) == 1 && (e & 1) == 1;
+        case BOUNDARY_REFLECT: return (s == 0 || s == 3) && (e == 0 || e == 3);
+        default:               return s == e;
+    }
+}
+
+static int bad_args(int rule, Boundary boundary, size_t width) {
+    return rule < 0 || rule > 255 || width == 0 || boundary < 0 || boundary >= BOUNDARY_GROW;
+}
+
+/*
+ * Function:  preimage_exists
+ * --------------------
+ * decides whether any row steps to row, by following the sets of nodes
+ * reachable from each start node. A row without one is a Garden of Eden.
+ *
+ *  rule:       elementary rule 0-255
+ *  boundary:   boundary of both rows, any but BOUNDARY_GROW
+ *  row:        packed like the engine, bit x % 64 of row[x / 64] is cell x
+ *  width:      cells in the row
+ *
+ *  returns: 1 if row has a preimage, 0 if not, -1 on bad arguments
+ */
+int preimage_exists(int rule, Boundary boundary, const uint64_t *row, size_t width) {
+    int step[2][16], lane[4], s, v, e;
+
+    if (bad_args(rule, boundary, width)) return -1;
+    for (int y = 0; y < 2; y++)
+        for (int set = 0; set < 16; set++) {
+            step[y][set] = 0;
+            for (v = 0; v < 4; v++)
+                if (set >> v & 1) step[y][set] |= edges(rule, v, y);
+        }
+
+    for (s = 0; s < 4; s++) lane[s] = 1 << s;
+    for (size_t x = 0; x < width; x++) {
+        const int *t = step[cell(row, x)];
+        lane[0] = t[lane[0]];
+        lane[1] = t[lane[1]];
+        lane[2] = t[lane[2]];
+        lane[3] = t[lane[3]];
+    }
+
+    for (s = 0; s < 4; s++)
+        for (e = 0; e < 4; e++)
+            if ((lane[s] >> e & 1) && allowed(boundary, s, e)) return 1;
+    return 0;
+}
+
+/*
+ * Function:  preimage_count
+ * --------------------
+ * counts the rows that step to row by counting the walks to each node
+ * from each start node. Counts past 64 bits are followed as doubles
+ * that are scaled down whenever they get large, which gives the base 2
+ * logarithm of counts of any size.
+ *
+ *  log2_count: receives log2 of the count, -INFINITY for none, may be NULL
+ *
+ *  returns: the count, UINT64_MAX if it's that or more, 0 on bad arguments
+ */
+uint64_t preimage_count(int rule, Boundary boundary, const uint64_t *row, size_t width,
+                        double *log2_count) {
+    uint64_t n[4][4] = {{0}}, next[4][4], total = 0;
+    double d[4][4] = {{0}}, dnext[4][4], dtotal = 0;
+    long scale = 0;
+    int to[2][4], s, v, e;
+
+    if (log2_count) *log2_count = -INFINITY;
+    if (bad_args(rule, boundary, width)) return 0;
+    for (int y = 0; y < 2; y++)
+        for (v = 0; v < 4; v++) to[y][v] = edges(rule, v, y);
+
+    for (s = 0; s < 4; s++) {
+        n[s][s] = 1;
+        d[s][s] = 1;
+    }
+    for (size_t x = 0; x < width; x++) {
+        const int *t = to[cell(row, x)];
+        double big = 0;
+        for (s = 0; s < 4; s++) {
+            for (e = 0; e < 4; e++) {
+                next[s][e] = 0;
+                dnext[s][e] = 0;
+            }
+            for (v = 0; v < 4; v++) {
+                for (e = 0; e < 4; e++) {
+                    if (!(t[v] >> e & 1)) continue;
+                    uint64_t sum = next[s][e] + n[s][v];
+                    next[s][e] = sum < n[s][v] ? UINT64_MAX : sum;
+                    dnext[s][e] += d[s][v];
+                }
+            }
+            for (e = 0; e < 4; e++) if (dnext[s][e] > big) big = dnext[s][e];
+        }
+        memcpy(n, next, sizeof(n));
+        memcpy(d, dnext, sizeof(d));
+        if (big > 0x1p512) {
+            for (s = 0; s < 4; s++)
+                for (e = 0; e < 4; e++) d[s][e] *= 0x1p-512;
+            scale += 512;
+        }
+    }
+
+    for (s = 0; s < 4; s++)
+        for (e = 0; e < 4; e++) {
+            if (!allowed(boundary, s, e)) continue;
+            uint64_t sum = total + n[s][e];
+            total = sum < total ? UINT64_MAX : sum;
+            dtotal += d[s][e];
+        }
+    if (log2_count && dtotal > 0) *log2_count = log2(dtotal) + scale;
+    return total;
+}
+
+/*
+ * Function:  preimages_init
+ * --------------------
+ * prepares to list the preimages of row. Working back from the end of
+ * the row, live[x] holds for each start node the nodes at position x
+ * from which the rest of the row can still be matched, so the listing
+ * never follows a dead end and each preimage costs at most O(width).
+ * Takes 2 bytes per cell.
+ *
+ *  arguments as for preimage_exists
+ *
+ *  returns: 0 on success, -1 on bad arguments or if out of memory
+ */
+int preimages_init(Preimages *p, int rule, Boundary boundary, const uint64_t *row,
+                   size_t width) {
+    size_t words = (width + 1 + 63) / 64;
+    int s, v, e;
+
+    memset(p, 0, sizeof(*p));
+    if (bad_args(rule, boundary, width)) return -1;
+    p->rule = rule;
+    p->boundary = boundary;
+    p->width = width;
+    p->start = -1;
+    p->row = malloc((width + 63) / 64 * sizeof(uint64_t));
+    p->cells = calloc(words, sizeof(uint64_t));
+    p->live = malloc((width + 1) * sizeof(uint16_t));
+    if (!p->row || !p->cells || !p->live) {
+        preimages_free(p);
+        return -1;
+    }
+    memcpy(p->row, row, (width + 63) / 64 * sizeof(uint64_t));
+
+    int back[2][16];
+    for (int y = 0; y < 2; y++)
+        for (int set = 0; set < 16; set++) {
+            back[y][set] = 0;
+            for (v = 0; v < 4; v++)
+                if (edges(rule, v, y) & set) back[y][set] |= 1 << v;
+        }
+
+    uint16_t live = 0;
+    for (s = 0; s < 4; s++)
+        for (e = 0; e < 4; e++)
+            if (allowed(boundary, s, e)) live |= 1 << (4 * s + e);
+    p->live[width] = live;
+    for (size_t x = width; x-- > 0;) {
+        const int *t = back[cell(row, x)];
+        live = t[live & 15] | t[live >> 4 & 15] << 4 | t[live >> 8 & 15] << 8 | t[live >> 12] << 12;
+        p->live[x] = live;
+    }
+    return 0;
+}
+
+static inline void put(uint64_t *words, size_t x, int v) {
+    uint64_t bit = 1ull << (x % 64);
+    words[x / 64] = v ? (words[x / 64] | bit) : (words[x / 64] & ~bit);
+}
+
+// node of cells x - 1 and x of the current preimage, x > 0
+static inline int node(const Preimages *p, size_t x) {
+    return 2 * cell(p->cells, x - 1) + cell(p->cells, x);
+}
+
+// whether cell x + 1 can be c given cells up to x, x + 1 may be the boundary cell
+static inline int can_extend(const Preimages *p, size_t x, int v, int c) {
+    int w = 2 * (v & 1) + c;
+    return (edges(p->rule, v, cell(p->row, x)) >> w & 1) && (p->live[x + 1] >> (4 * p->start + w) & 1);
+}
+
+// completes the preimage from cell x + 1 on, taking 0 over 1 for every cell
+static void fill(Preimages *p, size_t x, int v) {
+    for (; x < p->width; x++) {
+        int c = can_extend(p, x, v, 0) ? 0 : 1;
+        put(p->cells, x + 1, c);
+        v = 2 * (v & 1) + c;
+    }
+}
+
+/*
+ * Function:  preimage_next
+ * --------------------
+ * moves to the next preimage. Cells 0 to width - 1 of p->cells are the
+ * preimage, packed like the row; cell width is the boundary cell to its
+ * right. Preimages are listed by start node, the pair of the left
+ * boundary cell and cell 0, and then in lexicographic order of cells 1
+ * onwards, each exactly once.
+ *
+ *  returns: 1 if there is another preimage, 0 when they have all been listed
+ */
+int preimage_next(Preimages *p) {
+    if (p->start >= 0) {
+        // the last cell with another way to go, turned from 0 to 1
+        for (size_t x = p->width; x-- > 0;) {
+            int v = x ? node(p, x) : p->start;
+            if (!cell(p->cells, x + 1) && can_extend(p, x, v, 1)) {
+                put(p->cells, x + 1, 1);
+                fill(p, x + 1, 2 * (v & 1) + 1);
+                return 1;
+            }
+        }
+    }
+
+    while (++p->start < 4) {
+        if (!(p->live[0] >> (4 * p->start + p->start) & 1)) continue;
+        put(p->cells, 0, p->start & 1);
+        fill(p, 0, p->start);
+        return 1;
+    }
+    return 0;
+}
+
+void preimages_free(Preimages *p) {
+    free(p->row);
+    free(p->live);
+    free(p->cells);
+    p->row = p->cells = NULL;
+    p->live = NULL;
+}
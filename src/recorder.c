@@ -0,0 +1,466 @@
+#include <SDL2/SDL.h>
+#include <ctype.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "recorder.h"
+
+// GIF dictionary, twice the 4096 codes so linear probing stays short
+#define GIF_HASH_SIZE   8192
+#define GIF_MAX_CODE    4095
+
+/*
+ * The queue is a single producer, single consumer ring: the render loop
+ * only moves head and the writer thread only moves tail, so neither side
+ * takes a lock. The writer sleeps on the filled semaphore, which is
+ * posted once per frame and once more to stop it.
+ */
+struct Recorder {
+    FILE           *f;
+    RecordFormat    format;
+    int             width, height, fps;
+    size_t          frame_bytes;
+
+    int             slots;
+    unsigned char  *frames;
+    atomic_size_t   head, tail;
+    SDL_sem        *filled, *space;
+    SDL_Thread     *thread;
+
+    atomic_uint_fast64_t written;
+    uint64_t        dropped;
+    int             max_queued;
+
+    // writer state
+    unsigned char  *out;        /* converted frame */
+    unsigned char  *pending;    /* GIF frame held back until it changes */
+    int             pending_delay;
+    unsigned char   palette[256][3];
+    unsigned char   grays[256]; /* palette index for each gray */
+    unsigned char  *lut;        /* palette index for each 15 bit color */
+    uint32_t       *hash_keys;
+    uint16_t       *hash_codes;
+};
+
+static void put16(FILE *f, int v) {
+    fputc(v & 0xff, f);
+    fputc((v >> 8) & 0xff, f);
+}
+
+/* -------------
+ *
+ * GIF
+ *
+ * -------------
+ * */
+
+typedef struct {
+    FILE           *f;
+    uint32_t        acc;
+    int             bits;
+    unsigned char   block[255];
+    int             len;
+} GifBits;
+
+static void gif_bytes(GifBits *b) {
+    while (b->bits >= 8) {
+        b->block[b->len++] = b->acc & 0xff;
+        b->acc >>= 8;
+        b->bits -= 8;
+        if (b->len == 255) {
+            fputc(255, b->f);
+            fwrite(b->block, 1, 255, b->f);
+            b->len = 0;
+        }
+    }
+}
+
+static void gif_code(GifBits *b, int code, int size) {
+    b->acc |= (uint32_t)code << b->bits;
+    b->bits += size;
+    gif_bytes(b);
+}
+
+static void gif_finish(GifBits *b) {
+    if (b->bits) b->bits = 8;
+    gif_bytes(b);
+    if (b->len) {
+        fputc(b->len, b->f);
+        fwrite(b->block, 1, b->len, b->f);
+    }
+    fputc(0, b->f);
+}
+
+// nearest palette entry to a color
+static int gif_nearest(const Recorder *r, int red, int green, int blue) {
+    int i, best = 0, best_d = 1 << 30;
+    for (i = 0; i < 256; i++) {
+        int dr = red - r->palette[i][0], dg = green - r->palette[i][1], db = blue - r->palette[i][2];
+        int d = dr * dr + dg * dg + db * db;
+        if (d < best_d) { best = i; best_d = d; }
+    }
+    return best;
+}
+
+/*
+ * Function:  gif_palette
+ * --------------------
+ * builds a fixed palette of a 6x6x6 color cube and 40 more grays, and
+ * tables from colors to their nearest entry: one for each gray, as the
+ * cells and the gui are all gray, and one for each 15 bit color
+ *
+ */
+static int gif_palette(Recorder *r) {
+    int i, c;
+    for (i = 0; i < 216; i++) {
+        r->palette[i][0] = i / 36 * 51;
+        r->palette[i][1] = i / 6 % 6 * 51;
+        r->palette[i][2] = i % 6 * 51;
+    }
+    for (i = 216; i < 256; i++)
+        memset(r->palette[i], (i - 215) * 255 / 41, 3);
+
+    for (i = 0; i < 256; i++) r->grays[i] = gif_nearest(r, i, i, i);
+
+    r->lut = malloc(1 << 15);
+    if (!r->lut) return -1;
+    for (c = 0; c < 1 << 15; c++)
+        r->lut[c] = gif_nearest(r, (c >> 10) << 3 | 4, (c >> 5 & 31) << 3 | 4, (c & 31) << 3 | 4);
+    return 0;
+}
+
+static void gif_header(Recorder *r) {
+    fwrite("GIF89a", 1, 6, r->f);
+    put16(r->f, r->width);
+    put16(r->f, r->height);
+    fputc(0xf7, r->f);              /* 256 entry global palette */
+    fputc(0, r->f);
+    fputc(0, r->f);
+    fwrite(r->palette, 1, sizeof(r->palette), r->f);
+
+    // loop forever
+    fputc(0x21, r->f);
+    fputc(0xff, r->f);
+    fputc(11, r->f);
+    fwrite("NETSCAPE2.0", 1, 11, r->f);
+    fputc(3, r->f);
+    fputc(1, r->f);
+    put16(r->f, 0);
+    fputc(0, r->f);
+}
+
+// finds or adds prefix + k in the dictionary, returns the code or -1 if added
+static int gif_lookup(Recorder *r, int prefix, int k, int next) {
+    uint32_t key = ((uint32_t)prefix << 8 | k) + 1;
+    uint32_t h = (key * 2654435761u) >> (32 - 13);
+    while (r->hash_keys[h]) {
+        if (r->hash_keys[h] == key) return r->hash_codes[h];
+        h = (h + 1) & (GIF_HASH_SIZE - 1);
+    }
+    r->hash_keys[h] = key;
+    r->hash_codes[h] = next;
+    return -1;
+}
+
+/*
+ * Function:  gif_image
+ * --------------------
+ * writes one frame of palette indices with LZW compression
+ *
+ *  pixels:     width * height palette indices
+ *  delay:      time to show the frame in hundredths of a second
+ *
+ */
+static void gif_image(Recorder *r, const unsigned char *pixels, int delay) {
+    const int min_size = 8, clear = 1 << min_size;
+    GifBits b = { r->f, 0, 0, {0}, 0 };
+    size_t i, n = (size_t)r->width * r->height;
+
+    // graphic control extension with the delay, then the image descriptor
+    fputc(0x21, r->f);
+    fputc(0xf9, r->f);
+    fputc(4, r->f);
+    fputc(0, r->f);
+    put16(r->f, delay);
+    fputc(0, r->f);
+    fputc(0, r->f);
+
+    fputc(0x2c, r->f);
+    put16(r->f, 0);
+    put16(r->f, 0);
+    put16(r->f, r->width);
+    put16(r->f, r->height);
+    fputc(0, r->f);
+    fputc(min_size, r->f);
+
+    memset(r->hash_keys, 0, GIF_HASH_SIZE * sizeof(uint32_t));
+    int size = min_size + 1, next = clear + 2, prefix = pixels[0];
+    gif_code(&b, clear, size);
+
+    for (i = 1; i < n; i++) {
+        int code = gif_lookup(r, prefix, pixels[i], next);
+        if (code >= 0) {
+            prefix = code;
+            continue;
+        }
+
+        // prefix + pixels[i] just took code next, the decoder learns it
+        // one code later, so widths change a code after next reaches a
+        // power of two
+        gif_code(&b, prefix, size);
+        prefix = pixels[i];
+        if (next == GIF_MAX_CODE) {
+            // the dictionary is full, start over
+            gif_code(&b, clear, size);
+            memset(r->hash_keys, 0, GIF_HASH_SIZE * sizeof(uint32_t));
+            size = min_size + 1;
+            next = clear + 2;
+            continue;
+        }
+        if (next++ == 1 << size) size++;
+    }
+
+    // the decoder adds one more code when it reads the last one
+    gif_code(&b, prefix, size);
+    if (next == 1 << size) size++;
+    gif_code(&b, clear + 1, size);
+    gif_finish(&b);
+}
+
+// identical frames are merged into one with a longer delay
+static void gif_frame(Recorder *r, const unsigned char *rgba) {
+    size_t i, n = (size_t)r->width * r->height;
+    int delay = (100 + r->fps / 2) / r->fps;
+
+    for (i = 0; i < n; i++, rgba += 4)
+        r->out[i] = rgba[0] == rgba[1] && rgba[1] == rgba[2] ? r->grays[rgba[0]]
+                  : r->lut[(rgba[0] >> 3) << 10 | (rgba[1] >> 3) << 5 | (rgba[2] >> 3)];
+
+    if (r->pending_delay && r->pending_delay + delay <= 0xffff && memcmp(r->out, r->pending, n) == 0) {
+        r->pending_delay += delay;
+        return;
+    }
+    if (r->pending_delay) gif_image(r, r->pending, r->pending_delay);
+
+    unsigned char *tmp = r->pending;
+    r->pending = r->out;
+    r->out = tmp;
+    r->pending_delay = delay;
+}
+
+/* -------------
+ *
+ * Y4M and PPM
+ *
+ * -------------
+ * */
+
+// 4:4:4 planes with BT.601 studio range
+static void y4m_frame(Recorder *r, const unsigned char *rgba) {
+    size_t i, n = (size_t)r->width * r->height;
+    unsigned char *y = r->out, *u = y + n, *v = u + n;
+
+    for (i = 0; i < n; i++, rgba += 4) {
+        int red = rgba[0], green = rgba[1], blue = rgba[2];
+        y[i] = (( 66 * red + 129 * green +  25 * blue + 128) >> 8) + 16;
+        u[i] = ((-38 * red -  74 * green + 112 * blue + 128) >> 8) + 128;
+        v[i] = ((112 * red -  94 * green -  18 * blue + 128) >> 8) + 128;
+    }
+    fputs("FRAME\n", r->f);
+    fwrite(r->out, 1, 3 * n, r->f);
+}
+
+static void ppm_frame(Recorder *r, const unsigned char *rgba) {
+    size_t i, n = (size_t)r->width * r->height;
+    for (i = 0; i < n; i++, rgba += 4) memcpy(r->out + 3 * i, rgba, 3);
+    fprintf(r->f, "P6\n%d %d\n255\n", r->width, r->height);
+    fwrite(r->out, 1, 3 * n, r->f);
+}
+
+/* -------------
+ *
+ * QUEUE
+ *
+ * -------------
+ * */
+
+static int writer(void *data) {
+    Recorder *r = data;
+    for (;;) {
+        SDL_SemWait(r->filled);
+        size_t tail = atomic_load_explicit(&r->tail, memory_order_relaxed);
+        if (tail == atomic_load_explicit(&r->head, memory_order_acquire)) break;
+
+        const unsigned char *frame = r->frames + tail % r->slots * r->frame_bytes;
+        switch (r->format) {
+            case RECORD_GIF: gif_frame(r, frame); break;
+            case RECORD_Y4M: y4m_frame(r, frame); break;
+            case RECORD_PPM: ppm_frame(r, frame); break;
+        }
+
+        atomic_store_explicit(&r->tail, tail + 1, memory_order_release);
+        atomic_fetch_add_explicit(&r->written, 1, memory_order_relaxed);
+        SDL_SemPost(r->space);
+    }
+    return 0;
+}
+
+static int has_extension(const char *path, const char *ext) {
+    const char *dot = strrchr(path, '.');
+    if (!dot) return 0;
+    while (*ext && tolower((unsigned char) *++dot) == *ext) ext++;
+    return !*ext && !dot[1];
+}
+
+static void recorder_free(Recorder *r) {
+    if (r->filled) SDL_DestroySemaphore(r->filled);
+    if (r->space) SDL_DestroySemaphore(r->space);
+    free(r->frames);
+    free(r->out);
+    free(r->pending);
+    free(r->lut);
+    free(r->hash_keys);
+    free(r->hash_codes);
+    free(r);
+}
+
+/*
+ * Function:  recorder_open
+ * --------------------
+ * starts a recording. Paths ending in .gif give an animated GIF, .y4m a
+ * YUV4MPEG2 stream and anything else a stream of binary PPM images. A path
+ * of - writes Y4M to stdout, e.g. for piping into ffmpeg.
+ *
+ *  path:       file to write
+ *  width:      frame width in pixels
+ *  height:     frame height in pixels
+ *  fps:        frames per second to play back at
+ *  slots:      frames the queue holds before frames are dropped
+ *
+ *  returns: the recorder, or NULL if the size is over 65535 pixels or the
+ *           file or memory couldn't be had
+ */
+Recorder *recorder_open(const char *path, int width, int height, int fps, int slots) {
+    if (width < 1 || height < 1 || width > 0xffff || height > 0xffff) return NULL;
+
+    Recorder *r = calloc(1, sizeof(Recorder));
+    if (!r) return NULL;
+
+    r->width = width;
+    r->height = height;
+    r->fps = fps > 0 ? fps : 30;
+    r->slots = slots > 0 ? slots : 1;
+    r->frame_bytes = (size_t)width * height * 4;
+    r->format = strcmp(path, "-") == 0     ? RECORD_Y4M
+              : has_extension(path, "gif") ? RECORD_GIF
+              : has_extension(path, "y4m") ? RECORD_Y4M : RECORD_PPM;
+    atomic_init(&r->head, 0);
+    atomic_init(&r->tail, 0);
+    atomic_init(&r->written, 0);
+
+    r->frames = malloc(r->slots * r->frame_bytes);
+    r->out = malloc((size_t)width * height * 3);
+    r->filled = SDL_CreateSemaphore(0);
+    r->space = SDL_CreateSemaphore(0);
+    if (!r->frames || !r->out || !r->filled || !r->space) goto fail;
+
+    if (r->format == RECORD_GIF) {
+        r->pending = malloc((size_t)width * height);
+        r->hash_keys = malloc(GIF_HASH_SIZE * sizeof(uint32_t));
+        r->hash_codes = malloc(GIF_HASH_SIZE * sizeof(uint16_t));
+        if (!r->pending || !r->hash_keys || !r->hash_codes || gif_palette(r)) goto fail;
+    }
+
+    r->f = strcmp(path, "-") == 0 ? stdout : fopen(path, "wb");
+    if (!r->f) goto fail;
+    if (r->format == RECORD_GIF) gif_header(r);
+    if (r->format == RECORD_Y4M)
+        fprintf(r->f, "YUV4MPEG2 W%d H%d F%d:1 Ip A1:1 C444\n", width, height, r->fps);
+
+    r->thread = SDL_CreateThread(writer, "recorder", r);
+    if (!r->thread) {
+        if (r->f != stdout) fclose(r->f);
+        goto fail;
+    }
+    return r;
+
+fail:
+    recorder_free(r);
+    return NULL;
+}
+
+/*
+ * Function:  recorder_push
+ * --------------------
+ * queues a copy of a frame for the writer thread
+ *
+ *  rgba:       top down RGBA rows of the frame
+ *  wait:       wait for room if the queue is full, otherwise the frame is
+ *              dropped so the caller never stalls on encoding
+ *
+ *  returns: 0 if the frame was queued, -1 if it was dropped
+ */
+int recorder_push(Recorder *r, const unsigned char *rgba, int wait) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t tail;
+
+    while (head - (tail = atomic_load_explicit(&r->tail, memory_order_acquire)) == (size_t)r->slots) {
+        if (!wait) {
+            r->dropped++;
+            return -1;
+        }
+        SDL_SemWait(r->space);
+    }
+
+    memcpy(r->frames + head % r->slots * r->frame_bytes, rgba, r->frame_bytes);
+    atomic_store_explicit(&r->head, head + 1, memory_order_release);
+    SDL_SemPost(r->filled);
+
+    if ((int)(head + 1 - tail) > r->max_queued) r->max_queued = (int)(head + 1 - tail);
+    return 0;
+}
+
+/*
+ * Function:  recorder_status
+ * --------------------
+ * reports progress, called from the thread that pushes frames
+ *
+ */
+void recorder_status(Recorder *r, RecordStatus *status) {
+    size_t head = atomic_load_explicit(&r->head, memory_order_relaxed);
+    size_t tail = atomic_load_explicit(&r->tail, memory_order_acquire);
+    status->written = atomic_load_explicit(&r->written, memory_order_relaxed);
+    status->dropped = r->dropped;
+    status->queued = (int)(head - tail);
+    status->max_queued = r->max_queued;
+    status->slots = r->slots;
+}
+
+/*
+ * Function:  recorder_close
+ * --------------------
+ * waits for the queued frames to be written and closes the file
+ *
+ *  status:     final progress, may be NULL
+ *
+ *  returns: 0 on success, -1 if writing failed
+ */
+int recorder_close(Recorder *r, RecordStatus *status) {
+    SDL_SemPost(r->filled);
+    SDL_WaitThread(r->thread, NULL);
+
+    if (r->format == RECORD_GIF) {
+        if (r->pending_delay) gif_image(r, r->pending, r->pending_delay);
+        fputc(0x3b, r->f);
+    }
+
+    int failed = ferror(r->f) != 0;
+    if (r->f == stdout) failed |= fflush(r->f) != 0;
+    else                failed |= fclose(r->f) != 0;
+
+    if (status) recorder_status(r, status);
+    recorder_free(r);
+    return failed ? -1 : 0;
+}
@@ -6,28 +6,193 @@
 #include <SDL2/SDL.h>
 #include <SDL2/SDL_opengl.h>
 #include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
 #include "renderer.h"
 #include "atlas.inl"
 #include "automata.h"
+#include "glfuncs.h"
 
 #define BUFFER_SIZE 16384
 
-static GLfloat   tex_buf[BUFFER_SIZE *  8];
-static GLfloat  vert_buf[BUFFER_SIZE *  8];
-static GLubyte color_buf[BUFFER_SIZE * 16];
-static GLuint  index_buf[BUFFER_SIZE *  6];
+// the texture holds the atlas, then R_THUMB_COUNT thumbnails in rows below
+#define THUMB_COLUMNS   16
+#define TEXTURE_WIDTH   (THUMB_COLUMNS * R_THUMB_SIZE)
+#define TEXTURE_HEIGHT  (ATLAS_HEIGHT + R_THUMB_COUNT / THUMB_COLUMNS * R_THUMB_SIZE)
+
+// one corner of a quad, texture coordinates are atlas pixels and get scaled
+// by the texture matrix
+typedef struct {
+    GLshort  x, y;
+    GLshort  u, v;
+    mu_Color color;
+} Vertex;
+
+static Vertex   vert_buf[BUFFER_SIZE * 4];
+static GLushort index_buf[BUFFER_SIZE * 6];
 
 static int buf_idx;
 
+// batch the draw calls are also being recorded into, or NULL
+static r_Batch *recording;
+// a batch ran out of memory and stopped recording, see r_batch_end
+static int recording_failed;
+
+/* laid out strings, looked up by hash in sets of a few runs each and
+ * replaced least recently used first. microui measures the same labels
+ * many times a frame while laying them out. */
+#define TEXT_CACHE_SETS 32
+#define TEXT_CACHE_WAYS 4
+#define TEXT_RUN_MAX    64
+
+typedef struct {
+    uint32_t hash;
+    int      len, width, glyphs;
+    unsigned used;              /* last lookup, 0 for an empty run */
+    char     text[TEXT_RUN_MAX];
+    Vertex   quads[TEXT_RUN_MAX * 4];
+} TextRun;
+
+static TextRun  text_cache[TEXT_CACHE_SETS][TEXT_CACHE_WAYS];
+static unsigned text_tick;
+
+static GLuint vertex_buffer, index_buffer;
+
+// instanced cell grid, the program is 0 when the context can't run it
+static GLuint cell_program, cell_buffer;
+static GLint  cell_uniform_screen, cell_uniform_cols, cell_uniform_size, cell_uniform_colors;
+static int    cell_buffer_cap;
+
+#define CELL_STATE_ATTRIB 1
+
+// each instance is one cell, its four vertices are the corners of a
+// triangle strip found from gl_VertexID
+static const char *cell_vertex_shader =
+    "#version 140\n"
+    "in float state;\n"
+    "uniform vec2 screen;\n"
+    "uniform int cols;\n"
+    "uniform float size;\n"
+    "uniform vec4 colors[2];\n"
+    "out vec4 color;\n"
+    "void main() {\n"
+    "    vec2 corner = vec2(gl_VertexID & 1, gl_VertexID >> 1);\n"
+    "    vec2 cell = vec2(gl_InstanceID % cols, gl_InstanceID / cols);\n"
+    "    vec2 pos = (cell + corner) * size / screen;\n"
+    "    gl_Position = vec4(pos.x * 2.0 - 1.0, 1.0 - pos.y * 2.0, 0.0, 1.0);\n"
+    "    color = colors[state > 0.5 ? 1 : 0];\n"
+    "}\n";
+
+static const char *cell_fragment_shader =
+    "#version 140\n"
+    "in vec4 color;\n"
+    "out vec4 frag_color;\n"
+    "void main() {\n"
+    "    frag_color = color;\n"
+    "}\n";
+
 static SDL_Window *window;
 
+// size of the window, and of the offscreen target when there is one
+static int screen_width = SCREEN_WIDTH, screen_height = SCREEN_HEIGHT;
+
+// offscreen target and asynchronous read back of finished frames, the
+// fences tell when a pixel buffer can be mapped without waiting
+#define CAPTURE_BUFFERS 3
+
+static GLuint         offscreen_fbo, offscreen_color;
+static r_CaptureFn    capture_fn;
+static void          *capture_udata;
+static GLuint         capture_pbo[CAPTURE_BUFFERS];
+static GLsync         capture_fence[CAPTURE_BUFFERS];
+static int            capture_head, capture_pending;
+static unsigned char *capture_pixels;
+static size_t         capture_cap;      /* bytes in capture_pixels and each buffer */
+
+
+static GLuint compile_shader(GLenum type, const char *source) {
+    GLint ok;
+    char log[512];
+    GLuint shader = glCreateShader(type);
+    glShaderSource(shader, 1, &source, NULL);
+    glCompileShader(shader);
+    glGetShaderiv(shader, GL_COMPILE_STATUS, &ok);
+    if (!ok) {
+        glGetShaderInfoLog(shader, sizeof(log), NULL, log);
+        fprintf(stderr, "cell shader: %s\n", log);
+        glDeleteShader(shader);
+        return 0;
+    }
+    return shader;
+}
 
-void r_init(void) {
+/*
+ * Function:  init_cells
+ * --------------------
+ * builds the program for r_draw_cells, leaving cell_program 0 if the
+ * context has no GL 3.3 so quads are pushed instead
+ *
+ */
+static void init_cells(void) {
+    GLint ok;
+    if (gl_load_instancing() != 0) return;
+
+    GLuint vs = compile_shader(GL_VERTEX_SHADER, cell_vertex_shader);
+    GLuint fs = compile_shader(GL_FRAGMENT_SHADER, cell_fragment_shader);
+    if (vs && fs) {
+        cell_program = glCreateProgram();
+        glAttachShader(cell_program, vs);
+        glAttachShader(cell_program, fs);
+        glBindAttribLocation(cell_program, CELL_STATE_ATTRIB, "state");
+        glLinkProgram(cell_program);
+        glGetProgramiv(cell_program, GL_LINK_STATUS, &ok);
+        if (!ok) {
+            glDeleteProgram(cell_program);
+            cell_program = 0;
+        }
+    }
+    if (vs) glDeleteShader(vs);
+    if (fs) glDeleteShader(fs);
+    if (!cell_program) return;
+
+    cell_uniform_screen = glGetUniformLocation(cell_program, "screen");
+    cell_uniform_cols   = glGetUniformLocation(cell_program, "cols");
+    cell_uniform_size   = glGetUniformLocation(cell_program, "size");
+    cell_uniform_colors = glGetUniformLocation(cell_program, "colors");
+    glGenBuffers(1, &cell_buffer);
+}
+
+
+/* maps screen pixels to the viewport, top left origin. The scissor box
+ * starts out as the whole window and microui only sets it around clipped
+ * commands, so it has to follow the window too. */
+static void set_viewport(void) {
+    glViewport(0, 0, screen_width, screen_height);
+    glScissor(0, 0, screen_width, screen_height);
+    glMatrixMode(GL_PROJECTION);
+    glLoadIdentity();
+    glOrtho(0.0f, screen_width, screen_height, 0.0f, -1.0f, +1.0f);
+    glMatrixMode(GL_MODELVIEW);
+}
+
+
+static void init_gl(Uint32 window_flags) {
     /* init SDL window */
     window = SDL_CreateWindow(
             "Elementary Cellular Automata", SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED,
-            SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_OPENGL);
-    SDL_GL_CreateContext(window);
+            SCREEN_WIDTH, SCREEN_HEIGHT, SDL_WINDOW_OPENGL | window_flags);
+    if (!window || !SDL_GL_CreateContext(window)) {
+        fprintf(stderr, "can't create an OpenGL window: %s\n", SDL_GetError());
+        exit(EXIT_FAILURE);
+    }
+
+    const char *missing = gl_load();
+    if (missing) {
+        fprintf(stderr, "OpenGL function %s is not available\n", missing);
+        exit(EXIT_FAILURE);
+    }
 
     /* init gl */
     glEnable(GL_BLEND);
@@ -40,90 +205,196 @@ void r_init(void) {
     glEnableClientState(GL_TEXTURE_COORD_ARRAY);
     glEnableClientState(GL_COLOR_ARRAY);
 
-    /* init texture */
+    /* init matrices, they stay the same for every draw until a resize */
+    set_viewport();
+    glMatrixMode(GL_TEXTURE);
+    glLoadIdentity();
+    glScalef(1.0f / TEXTURE_WIDTH, 1.0f / TEXTURE_HEIGHT, 1.0f);
+    glMatrixMode(GL_MODELVIEW);
+    glLoadIdentity();
+
+    /* init buffers, the indices are the same for every batch so they are
+     * uploaded once */
+    for (int i = 0; i < BUFFER_SIZE; i++) {
+        index_buf[i * 6 + 0] = i * 4 + 0;
+        index_buf[i * 6 + 1] = i * 4 + 1;
+        index_buf[i * 6 + 2] = i * 4 + 2;
+        index_buf[i * 6 + 3] = i * 4 + 2;
+        index_buf[i * 6 + 4] = i * 4 + 3;
+        index_buf[i * 6 + 5] = i * 4 + 1;
+    }
+    glGenBuffers(1, &index_buffer);
+    glBindBuffer(GL_ELEMENT_ARRAY_BUFFER, index_buffer);
+    glBufferData(GL_ELEMENT_ARRAY_BUFFER, sizeof(index_buf), index_buf, GL_STATIC_DRAW);
+
+    glGenBuffers(1, &vertex_buffer);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vert_buf), NULL, GL_STREAM_DRAW);
+    glVertexPointer(2, GL_SHORT, sizeof(Vertex), (void *) offsetof(Vertex, x));
+    glTexCoordPointer(2, GL_SHORT, sizeof(Vertex), (void *) offsetof(Vertex, u));
+    glColorPointer(4, GL_UNSIGNED_BYTE, sizeof(Vertex), (void *) offsetof(Vertex, color));
+
+    /* init texture, the atlas with room for the thumbnails below it */
     GLuint id;
     glGenTextures(1, &id);
     glBindTexture(GL_TEXTURE_2D, id);
-    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, ATLAS_WIDTH, ATLAS_HEIGHT, 0,
-            GL_ALPHA, GL_UNSIGNED_BYTE, atlas_texture);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+    unsigned char *texture = calloc(TEXTURE_WIDTH * TEXTURE_HEIGHT, 1);
+    for (int y = 0; y < ATLAS_HEIGHT; y++)
+        memcpy(texture + y * TEXTURE_WIDTH, atlas_texture + y * ATLAS_WIDTH, ATLAS_WIDTH);
+    glTexImage2D(GL_TEXTURE_2D, 0, GL_ALPHA, TEXTURE_WIDTH, TEXTURE_HEIGHT, 0,
+            GL_ALPHA, GL_UNSIGNED_BYTE, texture);
+    free(texture);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
     glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+
+    init_cells();
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
     assert(glGetError() == 0);
 }
 
 
+void r_init(void) {
+    init_gl(SDL_WINDOW_RESIZABLE);
+}
+
+
+/*
+ * Function:  r_init_offscreen
+ * --------------------
+ * like r_init, but draws into a framebuffer object behind a hidden window
+ * so frames can be captured without a display. SDL still needs a video
+ * driver, without a display that is SDL_VIDEODRIVER=offscreen.
+ *
+ *  returns: 0 on success, -1 if the context has no framebuffer objects
+ */
+int r_init_offscreen(void) {
+    init_gl(SDL_WINDOW_HIDDEN);
+    if (gl_load_capture() != 0) return -1;
+
+    glGenRenderbuffers(1, &offscreen_color);
+    glBindRenderbuffer(GL_RENDERBUFFER, offscreen_color);
+    glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, screen_width, screen_height);
+    glGenFramebuffers(1, &offscreen_fbo);
+    glBindFramebuffer(GL_FRAMEBUFFER, offscreen_fbo);
+    glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_RENDERBUFFER, offscreen_color);
+    if (glCheckFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        offscreen_fbo = 0;
+        return -1;
+    }
+    return 0;
+}
+
+
 static void flush(void) {
     if (buf_idx == 0) { return; }
 
-    glViewport(0, 0, SCREEN_WIDTH, SCREEN_HEIGHT);
-    glMatrixMode(GL_PROJECTION);
-    glPushMatrix();
-    glLoadIdentity();
-    glOrtho(0.0f, SCREEN_WIDTH, SCREEN_HEIGHT, 0.0f, -1.0f, +1.0f);
-    glMatrixMode(GL_MODELVIEW);
-    glPushMatrix();
-    glLoadIdentity();
+    /* orphan the old storage so the driver doesn't wait for the previous
+     * batch to finish drawing before it can be overwritten */
+    glBufferData(GL_ARRAY_BUFFER, sizeof(vert_buf), NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, buf_idx * 4 * sizeof(Vertex), vert_buf);
+    glDrawElements(GL_TRIANGLES, buf_idx * 6, GL_UNSIGNED_SHORT, (void *) 0);
 
-    glTexCoordPointer(2, GL_FLOAT, 0, tex_buf);
-    glVertexPointer(2, GL_FLOAT, 0, vert_buf);
-    glColorPointer(4, GL_UNSIGNED_BYTE, 0, color_buf);
-    glDrawElements(GL_TRIANGLES, buf_idx * 6, GL_UNSIGNED_INT, index_buf);
+    buf_idx = 0;
+}
 
-    glMatrixMode(GL_MODELVIEW);
-    glPopMatrix();
-    glMatrixMode(GL_PROJECTION);
-    glPopMatrix();
 
-    buf_idx = 0;
+static Vertex *next_quad(void) {
+    if (buf_idx == BUFFER_SIZE) { flush(); }
+    return vert_buf + buf_idx++ * 4;
+}
+
+
+// stops a recording that can't grow, what it holds is kept for r_batch_free
+static void record_failed(void) {
+    recording = NULL;
+    recording_failed = 1;
+}
+
+
+// copies a quad just written to the buffer into the batch being recorded
+static void record_quad(const Vertex *v) {
+    if (!recording) { return; }
+    if (recording->count == recording->cap) {
+        int cap = recording->cap ? recording->cap * 2 : 256;
+        void *quads = realloc(recording->quads, cap * 4 * sizeof(Vertex));
+        if (!quads) { record_failed(); return; }
+        recording->quads = quads;
+        recording->cap = cap;
+    }
+    memcpy((Vertex *) recording->quads + recording->count++ * 4, v, 4 * sizeof(Vertex));
 }
 
 
 static void push_quad(mu_Rect dst, mu_Rect src, mu_Color color) {
-    if (buf_idx == BUFFER_SIZE) { flush(); }
+    Vertex *v = next_quad();
+
+    v[0] = (Vertex) { dst.x,         dst.y,         src.x,         src.y,         color };
+    v[1] = (Vertex) { dst.x + dst.w, dst.y,         src.x + src.w, src.y,         color };
+    v[2] = (Vertex) { dst.x,         dst.y + dst.h, src.x,         src.y + src.h, color };
+    v[3] = (Vertex) { dst.x + dst.w, dst.y + dst.h, src.x + src.w, src.y + src.h, color };
+
+    record_quad(v);
+}
+
+
+// length of a string cut to len bytes, len < 0 for the whole string
+static int text_length(const char *text, int len) {
+    int n = 0;
+    while (text[n] && n != len) { n++; }
+    return n;
+}
+
 
-    int texvert_idx = buf_idx *  8;
-    int   color_idx = buf_idx * 16;
-    int element_idx = buf_idx *  4;
-    int   index_idx = buf_idx *  6;
-    buf_idx++;
-
-    /* update texture buffer */
-    float x = src.x / (float) ATLAS_WIDTH;
-    float y = src.y / (float) ATLAS_HEIGHT;
-    float w = src.w / (float) ATLAS_WIDTH;
-    float h = src.h / (float) ATLAS_HEIGHT;
-    tex_buf[texvert_idx + 0] = x;
-    tex_buf[texvert_idx + 1] = y;
-    tex_buf[texvert_idx + 2] = x + w;
-    tex_buf[texvert_idx + 3] = y;
-    tex_buf[texvert_idx + 4] = x;
-    tex_buf[texvert_idx + 5] = y + h;
-    tex_buf[texvert_idx + 6] = x + w;
-    tex_buf[texvert_idx + 7] = y + h;
-
-    /* update vertex buffer */
-    vert_buf[texvert_idx + 0] = dst.x;
-    vert_buf[texvert_idx + 1] = dst.y;
-    vert_buf[texvert_idx + 2] = dst.x + dst.w;
-    vert_buf[texvert_idx + 3] = dst.y;
-    vert_buf[texvert_idx + 4] = dst.x;
-    vert_buf[texvert_idx + 5] = dst.y + dst.h;
-    vert_buf[texvert_idx + 6] = dst.x + dst.w;
-    vert_buf[texvert_idx + 7] = dst.y + dst.h;
-
-    /* update color buffer */
-    memcpy(color_buf + color_idx +  0, &color, 4);
-    memcpy(color_buf + color_idx +  4, &color, 4);
-    memcpy(color_buf + color_idx +  8, &color, 4);
-    memcpy(color_buf + color_idx + 12, &color, 4);
-
-    /* update index buffer */
-    index_buf[index_idx + 0] = element_idx + 0;
-    index_buf[index_idx + 1] = element_idx + 1;
-    index_buf[index_idx + 2] = element_idx + 2;
-    index_buf[index_idx + 3] = element_idx + 2;
-    index_buf[index_idx + 4] = element_idx + 3;
-    index_buf[index_idx + 5] = element_idx + 1;
+/*
+ * Function:  find_text
+ * --------------------
+ * looks a string up in the text cache, laying it out in place of the
+ * least recently used run of its set if it isn't there. Short strings
+ * only, the glyph quads of a run are kept at the origin.
+ *
+ *  text:       string to look up
+ *  len:        bytes of it to use, < 0 for all of it
+ *
+ *  returns: the run, or NULL if the string is too long to be cached
+ */
+static TextRun *find_text(const char *text, int len) {
+    len = text_length(text, len);
+    if (len > TEXT_RUN_MAX) { return NULL; }
+
+    uint32_t hash = 2166136261u;
+    for (int i = 0; i < len; i++) { hash = (hash ^ (unsigned char) text[i]) * 16777619u; }
+
+    TextRun *set = text_cache[hash % TEXT_CACHE_SETS], *run = set;
+    for (int i = 0; i < TEXT_CACHE_WAYS; i++) {
+        TextRun *r = &set[i];
+        if (r->used && r->hash == hash && r->len == len && !memcmp(r->text, text, len)) {
+            r->used = ++text_tick;
+            return r;
+        }
+        if (r->used < run->used) { run = r; }
+    }
+
+    run->hash = hash;
+    run->len = len;
+    run->width = 0;
+    run->glyphs = 0;
+    run->used = ++text_tick;
+    memcpy(run->text, text, len);
+    for (int i = 0; i < len; i++) {
+        if ((text[i] & 0xc0) == 0x80) { continue; }
+        int chr = mu_min((unsigned char) text[i], 127);
+        mu_Rect src = atlas[ATLAS_FONT + chr];
+        Vertex *v = run->quads + run->glyphs++ * 4;
+        int x = run->width;
+        v[0] = (Vertex) { x,         0,     src.x,         src.y         };
+        v[1] = (Vertex) { x + src.w, 0,     src.x + src.w, src.y         };
+        v[2] = (Vertex) { x,         src.h, src.x,         src.y + src.h };
+        v[3] = (Vertex) { x + src.w, src.h, src.x + src.w, src.y + src.h };
+        run->width += src.w;
+    }
+    return run;
 }
 
 
@@ -133,6 +404,19 @@ void r_draw_rect(mu_Rect rect, mu_Color color) {
 
 
 void r_draw_text(const char *text, mu_Vec2 pos, mu_Color color) {
+    TextRun *run = find_text(text, -1);
+    if (run) {
+        for (int i = 0; i < run->glyphs * 4; i += 4) {
+            Vertex *v = next_quad();
+            for (int k = 0; k < 4; k++) {
+                const Vertex *g = &run->quads[i + k];
+                v[k] = (Vertex) { g->x + pos.x, g->y + pos.y, g->u, g->v, color };
+            }
+            record_quad(v);
+        }
+        return;
+    }
+
     mu_Rect dst = { pos.x, pos.y, 0, 0 };
     for (const char *p = text; *p; p++) {
         if ((*p & 0xc0) == 0x80) { continue; }
@@ -146,15 +430,87 @@ void r_draw_text(const char *text, mu_Vec2 pos, mu_Color color) {
 }
 
 
+// where a thumbnail is in the texture
+static mu_Rect thumb_rect(int slot) {
+    return mu_rect(slot % THUMB_COLUMNS * R_THUMB_SIZE,
+                   ATLAS_HEIGHT + slot / THUMB_COLUMNS * R_THUMB_SIZE,
+                   R_THUMB_SIZE, R_THUMB_SIZE);
+}
+
+
 void r_draw_icon(int id, mu_Rect rect, mu_Color color) {
-    mu_Rect src = atlas[id];
+    mu_Rect src = id >= R_ICON_THUMB ? thumb_rect(id - R_ICON_THUMB) : atlas[id];
     int x = rect.x + (rect.w - src.w) / 2;
     int y = rect.y + (rect.h - src.h) / 2;
     push_quad(mu_rect(x, y, src.w, src.h), src, color);
 }
 
 
+/*
+ * Function:  r_draw_cells
+ * --------------------
+ * draws a grid of cells, one byte of state each, starting at the top left
+ * of the screen. With GL 3.3 only the states are sent and a vertex shader
+ * expands each into a quad, otherwise a quad is pushed per cell.
+ *
+ *  states:     cols * rows states, row by row, nonzero for live
+ *  cols:       cells per row
+ *  rows:       number of rows
+ *  size:       width and height of a cell in pixels
+ *  dead:       color of cells in state 0
+ *  live:       color of the other cells
+ *
+ */
+void r_draw_cells(const unsigned char *states, int cols, int rows, int size,
+                  mu_Color dead, mu_Color live) {
+    int count = cols * rows;
+    if (count <= 0) return;
+
+    if (!cell_program) {
+        for (int i = 0; i < count; i++)
+            push_quad(mu_rect(i % cols * size, i / cols * size, size, size),
+                      atlas[ATLAS_WHITE], states[i] ? live : dead);
+        return;
+    }
+
+    // keep the order of anything already batched
+    flush();
+
+    GLfloat colors[8] = {
+        dead.r / 255.f, dead.g / 255.f, dead.b / 255.f, dead.a / 255.f,
+        live.r / 255.f, live.g / 255.f, live.b / 255.f, live.a / 255.f,
+    };
+    glUseProgram(cell_program);
+    glUniform2f(cell_uniform_screen, screen_width, screen_height);
+    glUniform1i(cell_uniform_cols, cols);
+    glUniform1f(cell_uniform_size, size);
+    glUniform4fv(cell_uniform_colors, 2, colors);
+
+    /* the storage only grows, by doubling, and is orphaned at the same
+     * size each draw so the driver can recycle it while the grid resizes */
+    glBindBuffer(GL_ARRAY_BUFFER, cell_buffer);
+    if (count > cell_buffer_cap) {
+        if (!cell_buffer_cap) cell_buffer_cap = 4096;
+        while (cell_buffer_cap < count) cell_buffer_cap *= 2;
+    }
+    glBufferData(GL_ARRAY_BUFFER, cell_buffer_cap, NULL, GL_STREAM_DRAW);
+    glBufferSubData(GL_ARRAY_BUFFER, 0, count, states);
+    glVertexAttribPointer(CELL_STATE_ATTRIB, 1, GL_UNSIGNED_BYTE, GL_FALSE, 1, (void *) 0);
+    glVertexAttribDivisor(CELL_STATE_ATTRIB, 1);
+    glEnableVertexAttribArray(CELL_STATE_ATTRIB);
+
+    glDrawArraysInstanced(GL_TRIANGLE_STRIP, 0, 4, count);
+
+    glDisableVertexAttribArray(CELL_STATE_ATTRIB);
+    glUseProgram(0);
+    glBindBuffer(GL_ARRAY_BUFFER, vertex_buffer);
+}
+
+
 int r_get_text_width(const char *text, int len) {
+    TextRun *run = find_text(text, len);
+    if (run) { return run->width; }
+
     int res = 0;
     for (const char *p = text; *p && len--; p++) {
         if ((*p & 0xc0) == 0x80) { continue; }
@@ -170,9 +526,41 @@ int r_get_text_height(void) {
 }
 
 
+/*
+ * Function:  r_set_thumb
+ * --------------------
+ * replaces a thumbnail, which r_draw_icon draws for the icon
+ * R_ICON_THUMB + slot. Thumbnails are alpha masks like the font, they
+ * start out clear.
+ *
+ *  slot:       thumbnail 0 to R_THUMB_COUNT - 1
+ *  alpha:      R_THUMB_SIZE rows of R_THUMB_SIZE bytes
+ *
+ */
+void r_set_thumb(int slot, const unsigned char *alpha) {
+    mu_Rect dst = thumb_rect(slot);
+    flush();
+    glTexSubImage2D(GL_TEXTURE_2D, 0, dst.x, dst.y, dst.w, dst.h,
+                    GL_ALPHA, GL_UNSIGNED_BYTE, alpha);
+}
+
+
 void r_set_clip_rect(mu_Rect rect) {
+    if (recording) {
+        if (recording->clip_count == recording->clip_cap) {
+            int cap = recording->clip_cap ? recording->clip_cap * 2 : 16;
+            r_BatchClip *clips = realloc(recording->clips, cap * sizeof(r_BatchClip));
+            if (clips) {
+                recording->clips = clips;
+                recording->clip_cap = cap;
+            } else {
+                record_failed();
+            }
+        }
+        if (recording) recording->clips[recording->clip_count++] = (r_BatchClip) { recording->count, rect };
+    }
     flush();
-    glScissor(rect.x, SCREEN_HEIGHT - (rect.y + rect.h), rect.w, rect.h);
+    glScissor(rect.x, screen_height - (rect.y + rect.h), rect.w, rect.h);
 }
 
 
@@ -183,7 +571,219 @@ void r_clear(mu_Color clr) {
 }
 
 
+// waits for the oldest queued frame if wait is set
+static int capture_ready(int wait) {
+    GLenum status;
+    do {
+        status = glClientWaitSync(capture_fence[capture_head],
+                GL_SYNC_FLUSH_COMMANDS_BIT, wait ? 100000000 : 0);
+    } while (wait && status == GL_TIMEOUT_EXPIRED);
+    return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+}
+
+// hands the oldest queued frame to the callback, flipped to top down rows
+static void capture_deliver(void) {
+    int stride = screen_width * 4;
+    GLuint pbo = capture_pbo[capture_head];
+
+    glDeleteSync(capture_fence[capture_head]);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, pbo);
+    const unsigned char *src = glMapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+    if (src) {
+        for (int y = 0; y < screen_height; y++)
+            memcpy(capture_pixels + y * stride, src + (screen_height - 1 - y) * stride, stride);
+        glUnmapBuffer(GL_PIXEL_PACK_BUFFER);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+    capture_head = (capture_head + 1) % CAPTURE_BUFFERS;
+    capture_pending--;
+    if (src) capture_fn(capture_pixels, screen_width, screen_height, capture_udata);
+}
+
+// starts reading back the frame that was just drawn
+static void capture_queue(void) {
+    while (capture_pending && capture_ready(0)) capture_deliver();
+    if (capture_pending == CAPTURE_BUFFERS) {
+        capture_ready(1);
+        capture_deliver();
+    }
+
+    int i = (capture_head + capture_pending) % CAPTURE_BUFFERS;
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, capture_pbo[i]);
+    glReadPixels(0, 0, screen_width, screen_height, GL_RGBA, GL_UNSIGNED_BYTE, (void *) 0);
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    capture_fence[i] = glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+    capture_pending++;
+}
+
+
+// grows the read back buffers to hold at least bytes
+static int capture_reserve(size_t bytes) {
+    if (bytes <= capture_cap) return 0;
+
+    size_t cap = capture_cap ? capture_cap : bytes;
+    while (cap < bytes) cap *= 2;
+    unsigned char *pixels = (unsigned char *)realloc(capture_pixels, cap);
+    if (!pixels) return -1;
+    capture_pixels = pixels;
+    capture_cap = cap;
+
+    for (int i = 0; i < CAPTURE_BUFFERS; i++) {
+        glBindBuffer(GL_PIXEL_PACK_BUFFER, capture_pbo[i]);
+        glBufferData(GL_PIXEL_PACK_BUFFER, cap, NULL, GL_STREAM_READ);
+    }
+    glBindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+    return 0;
+}
+
+
+/*
+ * Function:  r_capture_start
+ * --------------------
+ * captures every frame from now on. r_present only starts copying a frame
+ * into a pixel buffer; the frame goes to fn once the GPU has finished it,
+ * usually a frame or two later, so capturing doesn't stall the render loop.
+ *
+ *  fn:         called with each frame as top down RGBA rows
+ *  udata:      passed on to fn
+ *
+ *  returns: 0 on success, -1 if the context can't read back asynchronously
+ */
+int r_capture_start(r_CaptureFn fn, void *udata) {
+    if (gl_load_capture() != 0) return -1;
+    capture_cap = 0;
+    glGenBuffers(CAPTURE_BUFFERS, capture_pbo);
+    if (capture_reserve((size_t)screen_width * screen_height * 4) != 0) {
+        glDeleteBuffers(CAPTURE_BUFFERS, capture_pbo);
+        return -1;
+    }
+
+    capture_fn = fn;
+    capture_udata = udata;
+    capture_head = capture_pending = 0;
+    return 0;
+}
+
+
+/*
+ * Function:  r_capture_stop
+ * --------------------
+ * waits for the frames still being read back and hands them to the
+ * callback, then stops capturing
+ *
+ */
+void r_capture_stop(void) {
+    if (!capture_fn) return;
+    while (capture_pending) {
+        capture_ready(1);
+        capture_deliver();
+    }
+    glDeleteBuffers(CAPTURE_BUFFERS, capture_pbo);
+    free(capture_pixels);
+    capture_pixels = NULL;
+    capture_cap = 0;
+    capture_fn = NULL;
+}
+
+
+/*
+ * Function:  r_resize
+ * --------------------
+ * follows a change in the size of the window. Frames still being read
+ * back are delivered at the old size first; the read back buffers only
+ * grow, by doubling, so dragging the window edge rarely reallocates.
+ *
+ *  width:      new width in pixels
+ *  height:     new height in pixels
+ *
+ */
+void r_resize(int width, int height) {
+    if (width < 1 || height < 1) return;
+    if (width == screen_width && height == screen_height) return;
+
+    flush();
+    while (capture_fn && capture_pending) {
+        capture_ready(1);
+        capture_deliver();
+    }
+
+    screen_width = width;
+    screen_height = height;
+    if (offscreen_fbo) {
+        glBindRenderbuffer(GL_RENDERBUFFER, offscreen_color);
+        glRenderbufferStorage(GL_RENDERBUFFER, GL_RGBA8, width, height);
+    }
+    if (capture_fn && capture_reserve((size_t)width * height * 4) != 0) {
+        fprintf(stderr, "out of memory, capture stopped\n");
+        r_capture_stop();
+    }
+    set_viewport();
+}
+
+
+/*
+ * Function:  r_batch_begin
+ * --------------------
+ * starts recording the quads and clip rects drawn from now on into a
+ * batch, replacing what it held, so they can be drawn again with
+ * r_batch_draw without building the quads again
+ *
+ */
+void r_batch_begin(r_Batch *batch) {
+    batch->count = 0;
+    batch->clip_count = 0;
+    recording = batch;
+    recording_failed = 0;
+}
+
+
+/*
+ * Function:  r_batch_end
+ * --------------------
+ * stops recording. The drawing itself never fails, but if the batch
+ * couldn't grow it misses the draw calls from then on.
+ *
+ *  returns: 0 if the batch holds everything drawn since r_batch_begin,
+ *           -1 if it ran out of memory
+ */
+int r_batch_end(void) {
+    recording = NULL;
+    return recording_failed ? -1 : 0;
+}
+
+
+void r_batch_draw(const r_Batch *batch) {
+    const Vertex *quads = batch->quads;
+    int i = 0, clip = 0;
+
+    while (i < batch->count || clip < batch->clip_count) {
+        if (clip < batch->clip_count && batch->clips[clip].at == i) {
+            r_set_clip_rect(batch->clips[clip++].rect);
+            continue;
+        }
+
+        int end = clip < batch->clip_count ? batch->clips[clip].at : batch->count;
+        while (i < end) {
+            if (buf_idx == BUFFER_SIZE) { flush(); }
+            int n = mu_min(end - i, BUFFER_SIZE - buf_idx);
+            memcpy(vert_buf + buf_idx * 4, quads + i * 4, n * 4 * sizeof(Vertex));
+            buf_idx += n;
+            i += n;
+        }
+    }
+}
+
+
+void r_batch_free(r_Batch *batch) {
+    free(batch->quads);
+    free(batch->clips);
+    memset(batch, 0, sizeof(*batch));
+}
+
+
 void r_present(void) {
     flush();
-    SDL_GL_SwapWindow(window);
+    if (capture_fn) capture_queue();
+    if (!offscreen_fbo) SDL_GL_SwapWindow(window);
 }
@@ -0,0 +1,341 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "seed.h"
+
+// precision of the density used by rng_bernoulli, in bits
+#define BERNOULLI_BITS 16
+
+static const char *seed_names[SEED_COUNT] = {
+    [ SEED_SINGLE  ] = "single",
+    [ SEED_RANDOM  ] = "random",
+    [ SEED_PATTERN ] = "pattern",
+    [ SEED_STRING  ] = "string",
+    [ SEED_FILE    ] = "file",
+};
+
+static inline uint64_t rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+// the output function of splitmix64, unrelated outputs for nearby inputs
+static inline uint64_t mix64(uint64_t z) {
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ull;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebull;
+    return z ^ (z >> 31);
+}
+
+/*
+ * Function:  rng_init
+ * --------------------
+ * seeds the generator, expanding the seed with splitmix64 so that nearby
+ * seeds give unrelated streams
+ *
+ *  rng:        generator to seed
+ *  seed:       any 64 bit value
+ *
+ */
+void rng_init(Rng *rng, uint64_t seed) {
+    for (int i = 0; i < 4; i++) rng->s[i] = mix64(seed += 0x9e3779b97f4a7c15ull);
+}
+
+/*
+ * Function:  rng_next
+ * --------------------
+ * advances the generator
+ *
+ *  returns: 64 uniformly random bits
+ */
+uint64_t rng_next(Rng *rng) {
+    uint64_t *s = rng->s;
+    uint64_t result = rotl(s[1] * 5, 7) * 9;
+    uint64_t t = s[1] << 17;
+
+    s[2] ^= s[0];
+    s[3] ^= s[1];
+    s[1] ^= s[2];
+    s[0] ^= s[3];
+    s[2] ^= t;
+    s[3] = rotl(s[3], 45);
+    return result;
+}
+
+/*
+ * Function:  bernoulli_digits
+ * --------------------
+ * rounds p to BERNOULLI_BITS binary digits for rng_bernoulli, filling
+ * words right away if that makes it 0 or 1
+ *
+ *  low:        receives the lowest set digit of the rounded p
+ *
+ *  returns: the digits, or 0 if words have been filled
+ */
+static uint32_t bernoulli_digits(double p, uint64_t *words, size_t count, int *low) {
+    uint32_t q = (uint32_t)(p * (1u << BERNOULLI_BITS) + 0.5);
+    if (p <= 0 || q == 0) {
+        memset(words, 0, count * sizeof(uint64_t));
+        return 0;
+    }
+    if (q >= (1u << BERNOULLI_BITS)) {
+        memset(words, 0xff, count * sizeof(uint64_t));
+        return 0;
+    }
+
+    // digits below the lowest set one can't settle any bit
+    for (*low = 0; !(q >> *low & 1); (*low)++);
+    return q;
+}
+
+/*
+ * Function:  rng_bernoulli
+ * --------------------
+ * fills words with bits that are set independently with probability p
+ *
+ * p is rounded to BERNOULLI_BITS binary digits 0.b1 b2 ... bn, which are
+ * compared from the first: each random word is the next binary digit of
+ * a uniform number for all 64 bits, and a bit is set as soon as its
+ * number falls below p and left clear as soon as it rises above it.
+ * Every word settles half of the undecided bits, so a word stops a few
+ * generator calls past the leading zeros of p instead of always taking
+ * one call per digit, and right away once the remaining digits of p are
+ * zero (a single call for p = 0.5).
+ *
+ *  rng:        generator to draw from
+ *  words:      output words
+ *  count:      number of words to fill
+ *  p:          probability of a set bit
+ *
+ */
+void rng_bernoulli(Rng *rng, uint64_t *words, size_t count, double p) {
+    size_t i;
+    int k, low;
+
+    uint32_t q = bernoulli_digits(p, words, count, &low);
+    if (!q) return;
+
+    for (i = 0; i < count; i++) {
+        uint64_t m = 0, open = ~0ull;
+        for (k = BERNOULLI_BITS - 1; k >= low && open; k--) {
+            uint64_t r = rng_next(rng);
+            if (q >> k & 1) {
+                m |= open & ~r;
+                open &= r;
+            } else {
+                open &= ~r;
+            }
+        }
+        words[i] = m;
+    }
+}
+
+/*
+ * Function:  rng_bernoulli_at
+ * --------------------
+ * rng_bernoulli without a generator to advance: random word k behind
+ * word i is the splitmix64 output for the counter 16 (index + i) + k,
+ * keyed by seed and stream. Any word can be drawn on its own and comes
+ * out the same however a row is split up between callers. The counter
+ * is stepped by adding, so each digit costs one mix64, and the digits
+ * are compared the same way, with the same early stop.
+ *
+ *  seed:       any 64 bit value
+ *  stream:     independent sequence to draw from, e.g. a generation
+ *  index:      position of words[0] in the stream
+ *  words:      output words
+ *  count:      number of words to fill
+ *  p:          probability of a set bit
+ *
+ */
+void rng_bernoulli_at(uint64_t seed, uint64_t stream, uint64_t index,
+                      uint64_t *words, size_t count, double p) {
+    const uint64_t gamma = 0x9e3779b97f4a7c15ull;
+    size_t i;
+    int k, low;
+
+    uint32_t q = bernoulli_digits(p, words, count, &low);
+    if (!q) return;
+
+    // splitmix64 state of the first digit of words[0], a word further on
+    // is BERNOULLI_BITS steps of gamma and a digit further on one less
+    uint64_t key = mix64(seed + mix64(stream + gamma));
+    uint64_t base = key + (index * BERNOULLI_BITS + BERNOULLI_BITS - 1) * gamma;
+    for (i = 0; i < count; i++, base += BERNOULLI_BITS * gamma) {
+        uint64_t x = base, m = 0, open = ~0ull;
+        for (k = BERNOULLI_BITS - 1; k >= low && open; k--, x -= gamma) {
+            uint64_t r = mix64(x);
+            if (q >> k & 1) {
+                m |= open & ~r;
+                open &= r;
+            } else {
+                open &= ~r;
+            }
+        }
+        words[i] = m;
+    }
+}
+
+/*
+ * Function:  seed_name
+ * --------------------
+ *  returns: printable name of a seed generator
+ */
+const char *seed_name(SeedKind kind) {
+    return (kind >= 0 && kind < SEED_COUNT) ? seed_names[kind] : "?";
+}
+
+/*
+ * Function:  seed_parse
+ * --------------------
+ * reads a generator from text of the form name[:argument], where the
+ * argument is the density for random, cells for pattern and string, and
+ * a path for file. spec->seed is left alone. spec->text points into arg.
+ *
+ *  spec:       parsed generator
+ *  arg:        text to parse, e.g. "random:0.3" or "pattern:0110"
+ *
+ *  returns: 0 on success, -1 if arg is not a valid generator
+ */
+int seed_parse(SeedSpec *spec, const char *arg) {
+    const char *colon = strchr(arg, ':');
+    size_t len = colon ? (size_t)(colon - arg) : strlen(arg);
+    const char *param = colon ? colon + 1 : NULL;
+
+    for (int k = 0; k < SEED_COUNT; k++) {
+        if (strlen(seed_names[k]) != len || strncmp(arg, seed_names[k], len) != 0)
+            continue;
+
+        spec->kind = k;
+        spec->text = param;
+        if (k == SEED_RANDOM) {
+            char *end;
+            spec->density = param ? strtod(param, &end) : 0.5;
+            if (param && (*end || spec->density < 0 || spec->density > 1)) return -1;
+        } else if (k != SEED_SINGLE && (!param || !*param)) {
+            return -1;
+        }
+        return 0;
+    }
+    return -1;
+}
+
+// characters that stand for cells, everything else but whitespace is dead
+static int is_cell(char c) { return c && !strchr(" \t\r\n", c); }
+static int is_live(char c) { return c == '1' || c == '#'; }
+
+static void set_bit(uint64_t *words, size_t i) {
+    words[i / 64] |= 1ull << (i % 64);
+}
+
+// places the cells described by text in the middle of the row
+static int place_text(const char *text, size_t len, uint64_t *words, size_t width) {
+    size_t i, n = 0, skip = 0, start = 0;
+    for (i = 0; i < len; i++) n += is_cell(text[i]);
+    if (n == 0) return -1;
+
+    if (n > width) skip = (n - width) / 2;
+    else           start = (width - n) / 2;
+
+    for (i = 0; i < len; i++) {
+        if (!is_cell(text[i])) continue;
+        if (skip) { skip--; continue; }
+        if (start >= width) break;
+        if (is_live(text[i])) set_bit(words, start);
+        start++;
+    }
+    return 0;
+}
+
+// repeats the cells described by text across the whole row
+static int fill_pattern(const char *text, uint64_t *words, size_t width) {
+    size_t i, k = 0, period = 0, nwords = (width + 63) / 64;
+    const char *p;
+    for (p = text; *p; p++) period += is_cell(*p);
+    if (period == 0) return -1;
+
+    // period words hold a whole number of repeats, bit by bit
+    size_t head = period < nwords ? period : nwords;
+    for (i = 0; i < head * 64; i++) {
+        while (!is_cell(text[k])) k = text[k] ? k + 1 : 0;
+        if (is_live(text[k])) set_bit(words, i);
+        k++;
+    }
+
+    // then the row repeats with a period of whole words
+    for (i = head; i < nwords; i++) words[i] = words[i - period];
+    return 0;
+}
+
+static int fill_file(const char *path, uint64_t *words, size_t width) {
+    FILE *f = fopen(path, "rb");
+    if (!f) return -1;
+
+    size_t len = 0, cap = 4096, got;
+    char *buf = malloc(cap);
+    while (buf && (got = fread(buf + len, 1, cap - len, f)) > 0) {
+        len += got;
+        if (len == cap) {
+            char *grown = realloc(buf, cap * 2);
+            if (!grown) {
+                free(buf);
+                buf = NULL;
+                break;
+            }
+            buf = grown;
+            cap *= 2;
+        }
+    }
+    fclose(f);
+    if (!buf) return -1;
+
+    int res = place_text(buf, len, words, width);
+    free(buf);
+    return res;
+}
+
+/*
+ * Function:  seed_fill
+ * --------------------
+ * writes an initial row in packed form, cell i is bit i % 64 of word i / 64
+ *
+ *  spec:       generator to use
+ *  words:      output, (width + 63) / 64 words
+ *  width:      number of cells in the row
+ *
+ *  returns: 0 on success, -1 if the generator has no cells or the file
+ *           can not be read (the row is left empty)
+ */
+int seed_fill(const SeedSpec *spec, uint64_t *words, size_t width) {
+    size_t nwords = (width + 63) / 64;
+    int res = 0;
+    Rng rng;
+
+    if (width == 0) return 0;
+
+    switch (spec->kind) {
+        case SEED_RANDOM:
+            rng_init(&rng, spec->seed);
+            rng_bernoulli(&rng, words, nwords, spec->density);
+            break;
+        case SEED_PATTERN:
+            memset(words, 0, nwords * sizeof(uint64_t));
+            res = fill_pattern(spec->text, words, width);
+            break;
+        case SEED_STRING:
+            memset(words, 0, nwords * sizeof(uint64_t));
+            res = place_text(spec->text, strlen(spec->text), words, width);
+            break;
+        case SEED_FILE:
+            memset(words, 0, nwords * sizeof(uint64_t));
+            res = fill_file(spec->text, words, width);
+            break;
+        default:
+            memset(words, 0, nwords * sizeof(uint64_t));
+            set_bit(words, width / 2);
+            break;
+    }
+
+    // keep the bits past the end of the row clear
+    if (width % 64) words[nwords - 1] &= ~0ull >> (64 - width % 64);
+    return res;
+}
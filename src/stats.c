@@ -0,0 +1,280 @@
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "stats.h"
+
+// byte counters in the accumulator overflow after 255 / 8 bytes
+#define ACC_FLUSH 31
+
+/*
+ * Function:  stats_init
+ * --------------------
+ * sets up a collector. For n <= STATS_TABLE_BLOCK a table maps the n + 7
+ * bits starting at each byte of a row to the counts of the 8 blocks that
+ * start in that byte, packed one byte per block value, so each byte of a
+ * row costs one lookup and one add per 8 block values.
+ *
+ *  s:          collector to set up
+ *  block:      n of the n-block counts 0-STATS_MAX_BLOCK, 0 for none
+ *
+ *  returns: 0 on success, -1 on a bad block size or if out of memory
+ */
+int stats_init(Stats *s, int block) {
+    memset(s, 0, sizeof(*s));
+    if (block < 0 || block > STATS_MAX_BLOCK) return -1;
+    s->block = block;
+    if (block == 0 || block > STATS_TABLE_BLOCK) return 0;
+
+    int values = 1 << block, bits = block + 7;
+    s->lanes = values > 8 ? values / 8 : 1;
+    s->table = calloc((size_t)s->lanes << bits, sizeof(uint64_t));
+    if (!s->table) return -1;
+
+    for (int chunk = 0; chunk < 1 << bits; chunk++) {
+        uint64_t *entry = s->table + (size_t)chunk * s->lanes;
+        for (int k = 0; k < 8; k++) {
+            int v = (chunk >> k) & (values - 1);
+            entry[v / 8] += 1ull << (8 * (v % 8));
+        }
+    }
+    return 0;
+}
+
+void stats_free(Stats *s) {
+    free(s->table);
+    s->table = NULL;
+}
+
+/*
+ * Function:  stats_begin
+ * --------------------
+ * starts collecting a row of the cells [lo, hi) of a packed buffer
+ *
+ */
+void stats_begin(Stats *s, long long lo, long long hi) {
+    s->lo = lo;
+    s->hi = hi;
+    s->mid = lo + (hi - lo) / 2;
+    s->cells = hi - lo;
+    s->ones = s->left = 0;
+    s->pending = lo / 64;
+    memset(s->counts, 0, sizeof(s->counts));
+    memset(s->acc, 0, sizeof(s->acc));
+    s->acc_bytes = 0;
+}
+
+static void flush(Stats *s) {
+    for (int v = 0; v < 1 << s->block && s->acc_bytes; v++)
+        s->counts[v] += (s->acc[v / 8] >> (8 * (v % 8))) & 0xff;
+    memset(s->acc, 0, sizeof(s->acc));
+    s->acc_bytes = 0;
+}
+
+// counts the blocks starting in word j, x is the word after it
+static void count_blocks(Stats *s, long long j, uint64_t w, uint64_t x) {
+    int n = s->block, k, b;
+    uint64_t mask = (1ull << n) - 1;
+    long long kmin = s->lo - 64 * j, kmax = s->hi - n - 64 * j;
+
+    if (s->table && kmin <= 0 && kmax >= 63) {
+        uint64_t bits = (1ull << (n + 7)) - 1;
+        for (b = 0; b < 8; b++) {
+            uint64_t chunk = b ? (w >> 8 * b) | (x << (64 - 8 * b)) : w;
+            const uint64_t *entry = s->table + (chunk & bits) * s->lanes;
+            for (int l = 0; l < s->lanes; l++) s->acc[l] += entry[l];
+        }
+        s->acc_bytes += 8;
+        if (s->acc_bytes + 8 > ACC_FLUSH) flush(s);
+        return;
+    }
+
+    // edges of the row, and blocks too long for a table
+    if (kmin < 0) kmin = 0;
+    if (kmax > 63) kmax = 63;
+    for (k = (int)kmin; k <= kmax; k++) {
+        uint64_t v = (w >> k) | (k ? x << (64 - k) : 0);
+        s->counts[v & mask]++;
+    }
+}
+
+/*
+ * Function:  stats_words
+ * --------------------
+ * adds the words [a, b) of the row, which must be final. Words are added
+ * in order, the stepper calls this for each chunk while it is in cache.
+ *
+ */
+void stats_words(Stats *s, const uint64_t *row, long long a, long long b) {
+    long long j;
+    for (j = a; j < b; j++) {
+        uint64_t w = row[j];
+        int ones = __builtin_popcountll(w);
+        s->ones += ones;
+        if (64 * j + 64 <= s->mid)  s->left += ones;
+        else if (64 * j < s->mid)   s->left += __builtin_popcountll(w & ((1ull << (s->mid - 64 * j)) - 1));
+    }
+
+    // a block starting in word j needs word j + 1 to be known
+    if (s->block)
+        for (j = s->pending; j < b - 1; j++) count_blocks(s, j, row[j], row[j + 1]);
+    s->pending = b - 1 > s->pending ? b - 1 : s->pending;
+}
+
+/*
+ * Function:  stats_end
+ * --------------------
+ * counts the blocks in the last word of the row, the results are ready
+ * after this
+ *
+ */
+void stats_end(Stats *s, const uint64_t *row) {
+    long long j, last = (s->hi - 1) / 64;
+    if (s->block && s->hi - s->lo >= s->block)
+        for (j = s->pending; j <= last; j++) count_blocks(s, j, row[j], j < last ? row[j + 1] : 0);
+    s->pending = last + 1;
+    flush(s);
+}
+
+/*
+ * Function:  stats_part
+ * --------------------
+ * starts collecting a stripe of the row s is collecting, for a worker
+ * stepping the words from a on. The worker adds its words with
+ * stats_words like a whole row, and stats_merge adds the results to s.
+ * part shares the block table of s.
+ *
+ */
+void stats_part(Stats *part, const Stats *s, long long a) {
+    *part = *s;
+    part->ones = part->left = 0;
+    part->pending = a;
+    memset(part->counts, 0, sizeof(part->counts));
+    memset(part->acc, 0, sizeof(part->acc));
+    part->acc_bytes = 0;
+}
+
+/*
+ * Function:  stats_merge
+ * --------------------
+ * adds a stripe collected by stats_part to s. The blocks starting in the
+ * last word of the stripe run into the next one, so they are counted
+ * here, once the whole row is final. Stripes are merged in order, and
+ * stats_end finishes the row after the last one.
+ *
+ *  row:        the row, final up to its last word
+ *
+ */
+void stats_merge(Stats *s, Stats *part, const uint64_t *row) {
+    long long j = part->pending, last = (s->hi - 1) / 64;
+
+    if (part->block && j < last) count_blocks(part, j, row[j], row[j + 1]);
+    if (j < last) j++;
+    flush(part);
+
+    s->ones += part->ones;
+    s->left += part->left;
+    for (int v = 0; s->block && v < 1 << s->block; v++) s->counts[v] += part->counts[v];
+    if (j > s->pending) s->pending = j;
+}
+
+/*
+ * Function:  stats_density
+ * --------------------
+ *  returns: fraction of live cells
+ */
+double stats_density(const Stats *s) {
+    return s->cells ? (double)s->ones / s->cells : 0;
+}
+
+/*
+ * Function:  stats_entropy
+ * --------------------
+ *  returns: Shannon entropy of the n-block frequencies divided by n, in
+ *           bits per cell
+ */
+double stats_entropy(const Stats *s) {
+    uint64_t total = 0;
+    double h = 0;
+    int v;
+
+    if (!s->block) return 0;
+    for (v = 0; v < 1 << s->block; v++) total += s->counts[v];
+    for (v = 0; v < 1 << s->block; v++) {
+        if (!s->counts[v]) continue;
+        double p = (double)s->counts[v] / total;
+        h -= p * log2(p);
+    }
+    return h / s->block;
+}
+
+/*
+ * Function:  stats_asymmetry
+ * --------------------
+ *  returns: density of the right half of the row minus that of the left
+ */
+double stats_asymmetry(const Stats *s) {
+    long long nl = s->mid - s->lo, nr = s->hi - s->mid;
+    double left = nl ? (double)s->left / nl : 0;
+    double right = nr ? (double)(s->ones - s->left) / nr : 0;
+    return right - left;
+}
+
+static void put64(FILE *f, uint64_t v) {
+    unsigned char b[8];
+    for (int i = 0; i < 8; i++) b[i] = (unsigned char)(v >> (8 * i));
+    fwrite(b, 1, 8, f);
+}
+
+/*
+ * Function:  stats_write_header
+ * --------------------
+ * starts a stream of records. The binary stream is the bytes "ECAS", then
+ * little endian 64 bit words: the format version (1) and n, followed by
+ * one record per generation (see stats_write).
+ *
+ */
+void stats_write_header(FILE *f, const Stats *s, int binary) {
+    if (binary) {
+        fwrite("ECAS", 1, 4, f);
+        put64(f, 1);
+        put64(f, s->block);
+        return;
+    }
+
+    fputs("generation,cells,ones,density,asymmetry", f);
+    if (s->block) {
+        fprintf(f, ",entropy%d", s->block);
+        for (int v = 0; v < 1 << s->block; v++) fprintf(f, ",b%d", v);
+    }
+    fputc('\n', f);
+}
+
+/*
+ * Function:  stats_write
+ * --------------------
+ * writes the statistics of one generation. A binary record is the little
+ * endian 64 bit words generation, cells, ones, left half ones and the 2^n
+ * block counts, where bit j of a block value is the j-th cell of the block.
+ *
+ */
+void stats_write(FILE *f, const Stats *s, uint64_t generation, int binary) {
+    int v;
+    if (binary) {
+        put64(f, generation);
+        put64(f, s->cells);
+        put64(f, s->ones);
+        put64(f, s->left);
+        for (v = 0; s->block && v < 1 << s->block; v++) put64(f, s->counts[v]);
+        return;
+    }
+
+    fprintf(f, "%llu,%llu,%llu,%.6f,%.6f", (unsigned long long)generation,
+            (unsigned long long)s->cells, (unsigned long long)s->ones,
+            stats_density(s), stats_asymmetry(s));
+    if (s->block) {
+        fprintf(f, ",%.6f", stats_entropy(s));
+        for (v = 0; v < 1 << s->block; v++) fprintf(f, ",%llu", (unsigned long long)s->counts[v]);
+    }
+    fputc('\n', f);
+}
@@ -0,0 +1,161 @@
+#include <SDL2/SDL.h>
+#include <stdatomic.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+#include "thumbs.h"
+
+#define THUMB_MAX_THREADS 8
+
+/*
+ * Workers take rules from a shared counter and draw each into its own
+ * slot of pixels, then mark it ready. Only the thread that called
+ * thumbs_start reads the slots, after seeing the mark, so the pixels need
+ * no lock. A finished thumbnail pushes an SDL_USEREVENT to wake a render
+ * loop waiting for input.
+ */
+struct Thumbs {
+    int             size;
+    unsigned char  *pixels;     /* size * size bytes per rule */
+    atomic_int      ready[THUMB_RULES];
+    char            delivered[THUMB_RULES];
+    int             remaining;  /* thumbnails not yet delivered */
+    atomic_int      next;       /* next rule to draw */
+    atomic_int      cancel;
+    int             threads;
+    SDL_Thread     *thread[THUMB_MAX_THREADS];
+};
+
+/*
+ * Function:  draw_thumb
+ * --------------------
+ * runs a rule from a single cell for size generations. The row is three
+ * thumbnails wide and only the middle third is kept, which its edges
+ * can't reach in that time, so the picture is that of an unbounded row.
+ *
+ *  rule:       rule to run
+ *  size:       cells across and generations down
+ *  out:        size * size bytes, 255 for live cells and 0 for dead
+ *
+ */
+static void draw_thumb(int rule, int size, unsigned char *out) {
+    SeedSpec spec = { SEED_SINGLE, 0, 0, NULL };
+    Engine e;
+    int x, y;
+
+    if (engine_init(&e, rule, 3 * size, BOUNDARY_FIXED0) != 0) {
+        memset(out, 0, (size_t)size * size);
+        return;
+    }
+    engine_seed(&e, &spec);
+    for (y = 0; y < size; y++) {
+        for (x = 0; x < size; x++) out[y * size + x] = engine_get(&e, size + x) ? 255 : 0;
+        engine_step(&e);
+    }
+    engine_free(&e);
+}
+
+static int worker(void *data) {
+    Thumbs *t = data;
+    SDL_Event event;
+
+    while (!atomic_load_explicit(&t->cancel, memory_order_relaxed)) {
+        int rule = atomic_fetch_add_explicit(&t->next, 1, memory_order_relaxed);
+        if (rule >= THUMB_RULES) break;
+
+        draw_thumb(rule, t->size, t->pixels + (size_t)rule * t->size * t->size);
+        atomic_store_explicit(&t->ready[rule], 1, memory_order_release);
+
+        memset(&event, 0, sizeof(event));
+        event.type = SDL_USEREVENT;
+        SDL_PushEvent(&event);
+    }
+    return 0;
+}
+
+/*
+ * Function:  thumbs_start
+ * --------------------
+ * starts drawing a thumbnail of each of the 256 rules in the background
+ *
+ *  size:       thumbnail width and height in cells
+ *  threads:    worker threads, 0 for one per CPU
+ *
+ *  returns: the generator, or NULL if out of memory or no thread started
+ */
+Thumbs *thumbs_start(int size, int threads) {
+    Thumbs *t = calloc(1, sizeof(*t));
+    int i;
+
+    if (!t || size < 1) {
+        free(t);
+        return NULL;
+    }
+    t->size = size;
+    t->remaining = THUMB_RULES;
+    t->pixels = malloc((size_t)THUMB_RULES * size * size);
+    if (!t->pixels) {
+        free(t);
+        return NULL;
+    }
+    for (i = 0; i < THUMB_RULES; i++) atomic_init(&t->ready[i], 0);
+    atomic_init(&t->next, 0);
+    atomic_init(&t->cancel, 0);
+
+    if (threads < 1) threads = SDL_GetCPUCount();
+    threads = threads < 1 ? 1 : threads > THUMB_MAX_THREADS ? THUMB_MAX_THREADS : threads;
+    for (i = 0; i < threads; i++) {
+        t->thread[t->threads] = SDL_CreateThread(worker, "thumbs", t);
+        if (t->thread[t->threads]) t->threads++;
+    }
+    if (!t->threads) {
+        free(t->pixels);
+        free(t);
+        return NULL;
+    }
+    return t;
+}
+
+/*
+ * Function:  thumbs_poll
+ * --------------------
+ * hands each thumbnail finished since the last call to fn, without
+ * waiting for the rest
+ *
+ *  returns: number of thumbnails delivered
+ */
+int thumbs_poll(Thumbs *t, ThumbFn fn, void *udata) {
+    int n = 0;
+    if (!t->remaining) return 0;
+
+    for (int rule = 0; rule < THUMB_RULES; rule++) {
+        if (t->delivered[rule] || !atomic_load_explicit(&t->ready[rule], memory_order_acquire))
+            continue;
+        fn(rule, t->pixels + (size_t)rule * t->size * t->size, t->size, udata);
+        t->delivered[rule] = 1;
+        t->remaining--;
+        n++;
+    }
+    return n;
+}
+
+// thumbnails not yet delivered by thumbs_poll
+int thumbs_pending(Thumbs *t) {
+    return t->remaining;
+}
+
+/*
+ * Function:  thumbs_free
+ * --------------------
+ * stops the workers after the thumbnails they are drawing and frees the
+ * generator
+ *
+ */
+void thumbs_free(Thumbs *t) {
+    if (!t) return;
+    atomic_store(&t->cancel, 1);
+    for (int i = 0; i < t->threads; i++) SDL_WaitThread(t->thread[i], NULL);
+    free(t->pixels);
+    free(t);
+}
@@ -0,0 +1,98 @@
+#include <stddef.h>
+#include <stdint.h>
+
+#include "renderer.h"
+#include "uicache.h"
+
+// quads drawn for each root container last time, indexed like the
+// context's container pool
+typedef struct {
+    int         valid;
+    uint64_t    hash;
+    r_Batch     batch;
+} UiCache;
+
+static UiCache cache[MU_CONTAINERPOOL_SIZE];
+
+// first command of a root container, the head jump is rewritten by mu_end
+static mu_Command *first_command(mu_Container *cnt) {
+    return (mu_Command *) ((char *) cnt->head + sizeof(mu_JumpCommand));
+}
+
+/*
+ * Function:  next_command
+ * --------------------
+ * steps through the commands of one root container, following the jumps
+ * that skip root containers begun inside it
+ *
+ *  returns: the next drawing command, or NULL at the end of the container
+ */
+static mu_Command *next_command(mu_Container *cnt, mu_Command *cmd) {
+    while (cmd != cnt->tail) {
+        if (cmd->type != MU_COMMAND_JUMP) return cmd;
+        cmd = cmd->jump.dst;
+    }
+    return NULL;
+}
+
+#define FOR_COMMANDS(cnt, cmd) \
+    for (cmd = next_command(cnt, first_command(cnt)); cmd; \
+         cmd = next_command(cnt, (mu_Command *) ((char *) cmd + cmd->base.size)))
+
+// FNV-1a of the drawing commands of a root container
+static uint64_t hash_container(mu_Container *cnt) {
+    uint64_t h = 0xcbf29ce484222325ull;
+    mu_Command *cmd;
+    FOR_COMMANDS(cnt, cmd) {
+        const unsigned char *p = (const unsigned char *) cmd;
+        for (int i = 0; i < cmd->base.size; i++) {
+            h ^= p[i];
+            h *= 0x100000001b3ull;
+        }
+    }
+    return h;
+}
+
+/*
+ * Function:  ui_draw
+ * --------------------
+ * draws the gui after mu_end, container by container in z order. The
+ * quads of a container are kept, and drawn again as they are while its
+ * commands hash the same, so only containers that changed have their
+ * text and frames turned into quads.
+ *
+ */
+void ui_draw(mu_Context *ctx) {
+    mu_Command *cmd;
+
+    for (int i = 0; i < ctx->root_list.idx; i++) {
+        mu_Container *cnt = ctx->root_list.items[i];
+        UiCache *c = &cache[cnt - ctx->containers];
+        uint64_t hash = hash_container(cnt);
+
+        if (c->valid && c->hash == hash) {
+            r_batch_draw(&c->batch);
+            continue;
+        }
+
+        r_batch_begin(&c->batch);
+        FOR_COMMANDS(cnt, cmd) {
+            switch (cmd->type) {
+                case MU_COMMAND_TEXT: r_draw_text(cmd->text.str, cmd->text.pos, cmd->text.color); break;
+                case MU_COMMAND_RECT: r_draw_rect(cmd->rect.rect, cmd->rect.color); break;
+                case MU_COMMAND_ICON: r_draw_icon(cmd->icon.id, cmd->icon.rect, cmd->icon.color); break;
+                case MU_COMMAND_CLIP: r_set_clip_rect(cmd->clip.rect); break;
+            }
+        }
+        // a container that couldn't be recorded is drawn from its commands again
+        c->valid = r_batch_end() == 0;
+        c->hash = hash;
+    }
+}
+
+void ui_free(void) {
+    for (int i = 0; i < MU_CONTAINERPOOL_SIZE; i++) {
+        r_batch_free(&cache[i].batch);
+        cache[i].valid = 0;
+    }
+}
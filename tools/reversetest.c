@@ -0,0 +1,95 @@
+/*
+ * Steps second-order rows forward and back again and checks that both
+ * rows come back bit for bit, for a spread of rules, every bounded
+ * boundary, widths that end partway through a word, with and without
+ * noise, and with the row cut into worker stripes.
+ *
+ *  usage: reversetest        (exits 1 if any row didn't come back)
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "engine.h"
+
+#define STEPS 37
+
+static const int      rules[]    = {0, 30, 45, 90, 110, 150, 184, 255};
+static const size_t   widths[]   = {1, 2, 63, 65, 200, 4097, 70001, 100001};
+static const Boundary bounds[]   = {BOUNDARY_PERIODIC, BOUNDARY_FIXED0,
+                                    BOUNDARY_FIXED1, BOUNDARY_REFLECT};
+static const int      threads[]  = {1, 3};
+static const double   noises[]   = {0, 0.01};
+
+#define COUNT(a) (sizeof(a) / sizeof(a[0]))
+
+/*
+ * Function:  roundtrip
+ * --------------------
+ * seeds a second-order row, steps it forward STEPS times and back as
+ * many, and compares both rows and the generation with where they began
+ *
+ *  returns: 1 if the rows came back, 0 if not, -1 if out of memory
+ */
+static int roundtrip(int rule, size_t width, Boundary boundary, int workers,
+                     double noise) {
+    EngineOptions opt = {workers, 0, 0};
+    SeedSpec now  = {SEED_RANDOM, 0.5, 1, NULL};
+    SeedSpec then = {SEED_RANDOM, 0.5, 2, NULL};
+    uint64_t *row, *prev;
+    Engine e;
+    int i, ok;
+
+    if (engine_init_ex(&e, rule, width, boundary, &opt) != 0) return -1;
+    row  = malloc(e.words * sizeof(uint64_t));
+    prev = malloc(e.words * sizeof(uint64_t));
+    if (!row || !prev || engine_seed(&e, &now) != 0 ||
+        engine_set_previous(&e, &then) != 0 ||
+        (noise > 0 && engine_set_noise(&e, noise, -1, 7) != 0)) {
+        free(row);
+        free(prev);
+        engine_free(&e);
+        return -1;
+    }
+
+    memcpy(row, e.row, e.words * sizeof(uint64_t));
+    memcpy(prev, e.prev, e.words * sizeof(uint64_t));
+    for (i = 0; i < STEPS; i++) engine_step(&e);
+    for (i = 0; i < STEPS; i++) engine_step_back(&e);
+
+    ok = e.generation == 0 &&
+         memcmp(row, e.row, e.words * sizeof(uint64_t)) == 0 &&
+         memcmp(prev, e.prev, e.words * sizeof(uint64_t)) == 0;
+
+    free(row);
+    free(prev);
+    engine_free(&e);
+    return ok;
+}
+
+int main(void) {
+    size_t r, w, b, t, n;
+    int runs = 0, bad = 0;
+
+    for (r = 0; r < COUNT(rules); r++)
+    for (w = 0; w < COUNT(widths); w++)
+    for (b = 0; b < COUNT(bounds); b++)
+    for (t = 0; t < COUNT(threads); t++)
+    for (n = 0; n < COUNT(noises); n++) {
+        int ok = roundtrip(rules[r], widths[w], bounds[b], threads[t], noises[n]);
+        if (ok < 0) {
+            fprintf(stderr, "reversetest: out of memory\n");
+            return 1;
+        }
+        if (!ok) {
+            fprintf(stderr, "rule %d width %zu %s threads %d noise %g: rows differ\n",
+                    rules[r], widths[w], boundary_name(bounds[b]), threads[t],
+                    noises[n]);
+            bad++;
+        }
+        runs++;
+    }
+
+    printf("reversetest: %d of %d round trips came back\n", runs - bad, runs);
+    return bad != 0;
+}
@@ -0,0 +1,93 @@
+/*
+ * Writes include/rules.inl: the smallest formula over &, |, ^ and ~ for
+ * each of the 256 elementary rules, as a macro RULE_<n>(l, c, r) on the
+ * left neighbors, cells and right neighbors of 64 cells at a time.
+ *
+ * A rule number is its own truth table over k = 4l + 2c + r, so l, c and
+ * r are the tables 0xf0, 0xcc and 0xaa and every formula is a byte. The
+ * cheapest formula of each table is found by relaxing all pairs of known
+ * tables until nothing gets cheaper, counting one per operator; a & ~b
+ * counts as one since it's one instruction on most targets.
+ *
+ *  usage: rulegen > include/rules.inl
+ */
+#include <stdio.h>
+
+enum { LEAF, NOT, AND, OR, XOR, ANDNOT };
+
+typedef struct {
+    int cost;       /* operators in the formula, -1 if none known yet */
+    int op;
+    int a, b;       /* tables of the operands */
+    const char *name;
+} Formula;
+
+static Formula f[256];
+
+static int relax(int t, int cost, int op, int a, int b) {
+    if (f[t].cost >= 0 && f[t].cost <= cost) return 0;
+    f[t].cost = cost;
+    f[t].op = op;
+    f[t].a = a;
+    f[t].b = b;
+    return 1;
+}
+
+static void print(int t, int top) {
+    static const char *ops[] = { [AND] = " & ", [OR] = " | ", [XOR] = " ^ ", [ANDNOT] = " & ~" };
+    const Formula *x = &f[t];
+
+    if (x->op == LEAF) {
+        fputs(x->name, stdout);
+        return;
+    }
+    if (!top) putchar('(');
+    if (x->op == NOT) {
+        putchar('~');
+        print(x->a, 0);
+    } else {
+        print(x->a, 0);
+        fputs(ops[x->op], stdout);
+        print(x->b, 0);
+    }
+    if (!top) putchar(')');
+}
+
+int main(void) {
+    int a, b, t, changed;
+
+    for (t = 0; t < 256; t++) f[t].cost = -1;
+    f[0x00] = (Formula){ 0, LEAF, 0, 0, "0" };
+    f[0xf0] = (Formula){ 0, LEAF, 0, 0, "l" };
+    f[0xcc] = (Formula){ 0, LEAF, 0, 0, "c" };
+    f[0xaa] = (Formula){ 0, LEAF, 0, 0, "r" };
+
+    do {
+        changed = 0;
+        for (a = 0; a < 256; a++) {
+            if (f[a].cost < 0) continue;
+            changed |= relax(~a & 0xff, f[a].cost + 1, NOT, a, 0);
+            for (b = 0; b < 256; b++) {
+                if (f[b].cost < 0) continue;
+                int cost = f[a].cost + f[b].cost + 1;
+                changed |= relax(a & b, cost, AND, a, b);
+                changed |= relax(a | b, cost, OR, a, b);
+                changed |= relax(a ^ b, cost, XOR, a, b);
+                changed |= relax(a & ~b & 0xff, cost, ANDNOT, a, b);
+            }
+        }
+    } while (changed);
+
+    printf("// generated by tools/rulegen.c, do not edit\n\n");
+    printf("// next state of 64 cells under each rule, the arguments must be parenthesized\n");
+    for (t = 0; t < 256; t++) {
+        printf("#define RULE_%d(l, c, r) (", t);
+        print(t, 1);
+        printf(")\n");
+    }
+
+    printf("\n// X(n) for every rule\n#define FOR_EACH_RULE(X)");
+    for (t = 0; t < 256; t++) printf("%s X(%d)", t % 16 ? "" : " \\\n   ", t);
+    printf("\n");
+    return 0;
+}